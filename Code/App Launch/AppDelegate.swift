@@ -89,13 +89,6 @@ class AppDelegate: UIResponder, UIApplicationDelegate {
             // User is signed in. We're by-passing the SignInVC screen. We need a delegate for SharingInvitation to accept sharing invitations in this case.
             sharingDelegate = SharingInviteDelegate()
             SharingInvitation.session.delegate = sharingDelegate
-
-            let albums = AlbumsVC.create()
-            SideMenu.session.setRootViewController(albums, animation: false)
-        }
-        else {
-            let signIn = SignInVC.create()
-            SideMenu.session.setRootViewController(signIn, animation: false)
         }
         
 #if DEBUG
@@ -141,9 +134,21 @@ class AppDelegate: UIResponder, UIApplicationDelegate {
             SyncServer.session.stopSync()
         }
         
-        Migrations.session.launch()
-        MediaHandler.setup()
-        PreviewManager.setup()
+        // Until any migrations are done, nothing may change objects. So the first screen (the albums screen syncs when it appears) and media handling start after.
+        Migrations.session.launch {
+            if SignInManager.session.userIsSignedIn {
+                let albums = AlbumsVC.create()
+                SideMenu.session.setRootViewController(albums, animation: false)
+            }
+            else {
+                let signIn = SignInVC.create()
+                SideMenu.session.setRootViewController(signIn, animation: false)
+            }
+            
+            ImageMediaObject.backfillOriginalSizes()
+            MediaHandler.setup()
+            PreviewManager.setup()
+        }
         
         // For [2] below.
         UNUserNotificationCenter.current().delegate = self
@@ -196,6 +201,7 @@ class AppDelegate: UIResponder, UIApplicationDelegate {
     func application(_ application: UIApplication, didReceiveRemoteNotification userInfo: [AnyHashable : Any]) {
         // Not needed or called given [2].
         // Notifications.session.application(application, didReceiveRemoteNotification: userInfo)
+        MediaHandler.session.syncController.pushNotificationReceived()
     }
 
     func applicationWillResignActive(_ application: UIApplication) {
@@ -227,6 +233,8 @@ extension AppDelegate: UNUserNotificationCenterDelegate {
     // [2]. This method will be called when app received push notifications in foreground
     // See also https://stackoverflow.com/questions/14872088/get-push-notification-while-app-in-foreground-ios
     func userNotificationCenter(_ center: UNUserNotificationCenter, willPresent notification: UNNotification, withCompletionHandler completionHandler: @escaping (UNNotificationPresentationOptions) -> Void) {
+        // Someone changed an album; rather than wait for the next periodic sync, pick that up now.
+        MediaHandler.session.syncController.pushNotificationReceived()
         completionHandler([.alert, .badge, .sound])
     }
 }
@@ -0,0 +1,213 @@
+//
+//  BinaryLogDestination.swift
+//  SharedImages
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import Foundation
+import XCGLogger
+
+// A compact XCGLogger destination: rather than formatting the date, thread, file, line and function into each message, it records a call site id, the level, a timestamp, the thread id and the raw message into a memory-mapped ring file. The call sites (file, line, function) are written once each, to a separate text file. Decode with Tools/decodeBinaryLog.py.
+//
+// Ring file layout (little endian):
+//  Header (32 bytes): "XCGB", UInt32 version, UInt64 capacity of the record area, UInt64 next write offset, UInt64 number of times the ring has wrapped.
+//  Records: UInt16 marker, UInt8 type, UInt8 level, UInt32 call site id, Float64 timestamp (seconds since 1970), UInt64 thread id, UInt32 message length, message (UTF8).
+// A record never straddles the end of the ring. If there isn't room for it, a pad record is written (if there's room for its marker and type) and the record goes at the start of the ring.
+class BinaryLogDestination: BaseDestination {
+    static let magic: [UInt8] = Array("XCGB".utf8)
+    static let version: UInt32 = 1
+    static let headerSize = 32
+    static let recordMarker: UInt16 = 0xB10C
+    static let recordHeaderSize = 28
+    
+    enum RecordType: UInt8 {
+        case message = 1
+        case pad = 2
+    }
+    
+    // A file and line identify a call site; the function name comes along for the call sites file.
+    private struct CallSiteKey: Hashable {
+        let fileName: String
+        let lineNumber: Int
+    }
+    
+    private let capacity: Int
+    private var mapped: UnsafeMutableRawPointer?
+    private var writeOffset = 0
+    private var wraps: UInt64 = 0
+    
+    private let callSitesURL: URL
+    private var callSites = [CallSiteKey: UInt32]()
+    
+    // On the heap, because the address of a Swift stored property isn't stable.
+    private let lock: UnsafeMutablePointer<os_unfair_lock> = {
+        let lock = UnsafeMutablePointer<os_unfair_lock>.allocate(capacity: 1)
+        lock.initialize(to: os_unfair_lock())
+        return lock
+    }()
+    
+    // The ring file is created if needed, and is `capacity` bytes, plus the header. An existing ring file is appended to if its capacity matches; otherwise it is started over.
+    init?(ringFileURL: URL, capacity: Int = 1024 * 1024, identifier: String) {
+        self.capacity = capacity
+        callSitesURL = ringFileURL.appendingPathExtension("sites")
+        super.init(identifier: identifier)
+        
+        let fileSize = BinaryLogDestination.headerSize + capacity
+        let fd = open(ringFileURL.path, O_RDWR | O_CREAT, 0o644)
+        guard fd >= 0 else {
+            return nil
+        }
+        defer {close(fd)}
+        
+        var existingSize = stat()
+        guard fstat(fd, &existingSize) == 0 else {
+            return nil
+        }
+        
+        let reuse = Int(existingSize.st_size) == fileSize
+        if !reuse {
+            guard ftruncate(fd, 0) == 0, ftruncate(fd, off_t(fileSize)) == 0 else {
+                return nil
+            }
+        }
+        
+        guard let pointer = mmap(nil, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0), pointer != MAP_FAILED else {
+            return nil
+        }
+        
+        mapped = pointer
+        
+        if reuse && Array(UnsafeRawBufferPointer(start: pointer, count: 4)) == BinaryLogDestination.magic {
+            writeOffset = Int(pointer.load(fromByteOffset: 16, as: UInt64.self).littleEndian)
+            wraps = pointer.load(fromByteOffset: 24, as: UInt64.self).littleEndian
+            if writeOffset > capacity {
+                writeOffset = 0
+            }
+            loadCallSites()
+        }
+        else {
+            pointer.copyMemory(from: BinaryLogDestination.magic, byteCount: 4)
+            pointer.storeBytes(of: BinaryLogDestination.version.littleEndian, toByteOffset: 4, as: UInt32.self)
+            pointer.storeBytes(of: UInt64(capacity).littleEndian, toByteOffset: 8, as: UInt64.self)
+            try? FileManager.default.removeItem(at: callSitesURL)
+            storeOffsets()
+        }
+    }
+    
+    deinit {
+        if let mapped = mapped {
+            munmap(mapped, BinaryLogDestination.headerSize + capacity)
+        }
+        
+        lock.deinitialize(count: 1)
+        lock.deallocate()
+    }
+    
+    // Skips all string formatting done by `BaseDestination`.
+    override func process(logDetails: LogDetails) {
+        var logDetails = logDetails
+        var message = logDetails.message
+        guard !shouldExclude(logDetails: &logDetails, message: &message) else {
+            return
+        }
+        
+        var threadID: UInt64 = 0
+        pthread_threadid_np(nil, &threadID)
+        
+        os_unfair_lock_lock(lock)
+        defer {os_unfair_lock_unlock(lock)}
+
+        let callSite = callSiteID(logDetails: logDetails)
+        var utf8 = message.utf8CString
+        
+        // Drop the terminating NUL, and keep what does fit.
+        let length = min(utf8.count - 1, capacity - BinaryLogDestination.recordHeaderSize)
+        utf8.withUnsafeMutableBytes { bytes in
+            writeRecord(level: UInt8(logDetails.level.rawValue), callSite: callSite, timestamp: logDetails.date.timeIntervalSince1970, threadID: threadID, message: UnsafeRawBufferPointer(rebasing: bytes[0..<length]))
+        }
+    }
+    
+    override func processInternal(logDetails: LogDetails) {
+        process(logDetails: logDetails)
+    }
+    
+    override func output(logDetails: LogDetails, message: String) {
+    }
+    
+    // Lock must be held.
+    private func writeRecord(level: UInt8, callSite: UInt32, timestamp: Double, threadID: UInt64, message: UnsafeRawBufferPointer) {
+        guard let mapped = mapped else {
+            return
+        }
+        
+        let records = mapped + BinaryLogDestination.headerSize
+        let recordSize = BinaryLogDestination.recordHeaderSize + message.count
+        
+        if writeOffset + recordSize > capacity {
+            if capacity - writeOffset >= 3 {
+                records.storeBytes(of: BinaryLogDestination.recordMarker.littleEndian, toByteOffset: writeOffset, as: UInt16.self)
+                records.storeBytes(of: RecordType.pad.rawValue, toByteOffset: writeOffset + 2, as: UInt8.self)
+            }
+            writeOffset = 0
+            wraps += 1
+        }
+        
+        let record = records + writeOffset
+        record.storeBytes(of: BinaryLogDestination.recordMarker.littleEndian, toByteOffset: 0, as: UInt16.self)
+        record.storeBytes(of: RecordType.message.rawValue, toByteOffset: 2, as: UInt8.self)
+        record.storeBytes(of: level, toByteOffset: 3, as: UInt8.self)
+        record.storeBytes(of: callSite.littleEndian, toByteOffset: 4, as: UInt32.self)
+        record.storeBytes(of: timestamp.bitPattern.littleEndian, toByteOffset: 8, as: UInt64.self)
+        record.storeBytes(of: threadID.littleEndian, toByteOffset: 16, as: UInt64.self)
+        record.storeBytes(of: UInt32(message.count).littleEndian, toByteOffset: 24, as: UInt32.self)
+        if let base = message.baseAddress {
+            (record + BinaryLogDestination.recordHeaderSize).copyMemory(from: base, byteCount: message.count)
+        }
+        
+        writeOffset += recordSize
+        storeOffsets()
+    }
+    
+    private func storeOffsets() {
+        mapped?.storeBytes(of: UInt64(writeOffset).littleEndian, toByteOffset: 16, as: UInt64.self)
+        mapped?.storeBytes(of: wraps.littleEndian, toByteOffset: 24, as: UInt64.self)
+    }
+    
+    // Lock must be held. The first time a call site is seen, it gets appended to the call sites file as: <id>\t<file>\t<line>\t<function>
+    private func callSiteID(logDetails: LogDetails) -> UInt32 {
+        let key = CallSiteKey(fileName: logDetails.fileName, lineNumber: logDetails.lineNumber)
+        if let id = callSites[key] {
+            return id
+        }
+        
+        let id = UInt32(callSites.count + 1)
+        callSites[key] = id
+        
+        let line = "\(id)\t\(logDetails.fileName)\t\(logDetails.lineNumber)\t\(logDetails.functionName)\n"
+        if let handle = try? FileHandle(forWritingTo: callSitesURL) {
+            handle.seekToEndOfFile()
+            handle.write(line.data(using: .utf8)!)
+            handle.closeFile()
+        }
+        else {
+            try? line.write(to: callSitesURL, atomically: false, encoding: .utf8)
+        }
+        
+        return id
+    }
+    
+    private func loadCallSites() {
+        guard let contents = try? String(contentsOf: callSitesURL, encoding: .utf8) else {
+            return
+        }
+        
+        for line in contents.split(separator: "\n") {
+            let fields = line.split(separator: "\t", maxSplits: 3, omittingEmptySubsequences: false)
+            if fields.count >= 3, let id = UInt32(fields[0]), let lineNumber = Int(fields[2]) {
+                callSites[CallSiteKey(fileName: String(fields[1]), lineNumber: lineNumber)] = id
+            }
+        }
+    }
+}
@@ -12,6 +12,7 @@ import XCGLogger
 class Logger {
     private static var session = Logger()
     private var fileDestination:AutoRotatingFileDestination!
+    private var binaryDestination:BinaryLogDestination?
     
     private static var logFileURL: URL {
         let urls = FileManager.default.urls(for: .documentDirectory, in: .userDomainMask)
@@ -19,6 +20,11 @@ class Logger {
         return result
     }
     
+    // Decode with Tools/decodeBinaryLog.py; the call sites are in the same directory, with an added ".sites" extension.
+    static var binaryLogFileURL: URL {
+        return logFileURL.appendingPathExtension("bin")
+    }
+    
     static var archivedFileURLs: [URL] {
         return session.fileDestination.archivedFileURLs() + [logFileURL]
     }
@@ -74,6 +80,20 @@ class Logger {
 
         // Add the destination to the logger
         log.add(destination: session.fileDestination)
+        
+        // A bit more than the other destinations in production builds: warnings too. Not info or below there though. XCGLogger builds a message, interpolating it at the call site, as soon as any destination takes its level-- and Log.msg and Log.special, including SyncServer's per-object dumps, log at info. This destination only records the built string, so taking info would cost every one of those the formatting it was meant to save.
+        var binaryLevel:XCGLogger.Level
+#if DEBUG
+        binaryLevel = .verbose
+#else
+        binaryLevel = .warning
+#endif
+
+        session.binaryDestination = BinaryLogDestination(ringFileURL: binaryLogFileURL, identifier: "advancedLogger.binaryDestination")
+        if let binaryDestination = session.binaryDestination {
+            binaryDestination.outputLevel = binaryLevel
+            log.add(destination: binaryDestination)
+        }
 
         // Add basic app info, version info etc, to the start of the logs
         log.logAppDetails()
@@ -7,68 +7,263 @@
 //
 
 import Foundation
+import CoreData
 import SMCoreLib
 import SyncServer
+import NVActivityIndicatorView
 
 class Migrations {
     static let session = Migrations()
-    
+
 //    private static let migration1 = SMPersistItemInt(name:"Migrations.migration1", initialIntValue:0,  persistType: .userDefaults)
 //    private static let coreDataMigration_v0_16_3 = SMPersistItemBool(name: "Migrations.coreDataMigration_v0_16_3", initialBoolValue: false, persistType: .userDefaults)
 //    private static let signOutMigration_v0_16_3 = SMPersistItemBool(name: "Migrations.signOutMigration_v0_16_3", initialBoolValue: false, persistType: .userDefaults)
 //    private static let v0_17_4 = SMPersistItemBool(name: "Migrations.v0_17_4", initialBoolValue: false, persistType: .userDefaults)
-
+    
     private static let v0_18_3 = SMPersistItemBool(name: "Migrations.v0_18_3", initialBoolValue: false, persistType: .userDefaults)
+    private static let v0_18_3Checkpoint = SMPersistItemString(name: "Migrations.v0_18_3.checkpoint", initialStringValue: "", persistType: .userDefaults)
     
     // The CoreData migration for v1.5 messed up the discussion/image relations. Going to fix this manually, here.
     private static let v1_5 = SMPersistItemBool(name: "Migrations.v1_5", initialBoolValue: false, persistType: .userDefaults)
+    private static let v1_5Checkpoint = SMPersistItemString(name: "Migrations.v1_5.checkpoint", initialStringValue: "", persistType: .userDefaults)
+    
+    // Objects fetched, changed and saved at a time. Keeps memory use flat, however large the library.
+    let batchSize: Int
     
-    private init() {
+    struct Step {
+        let entityName: String
+        let predicate: NSPredicate?
+        
+        // Changes a batch of objects; they're saved after.
+        let migrate: ([FileObject])->()
     }
     
-    // Run this near or at the very end of the launch sequence in the app delegate-- so all of the setup is done.
-    func launch() {
-        if !Migrations.v0_18_3.boolValue {
-            Migrations.v0_18_3.boolValue = true
-            
-            let discussions = DiscussionFileObject.fetchAll()
-            discussions.forEach { discussion in
-                discussion.gone = nil
-                discussion.readProblem = false
+    // Steps are run in order, in batches of objects ordered by uuid; objects without a uuid are done at the start of their step. The checkpoint records the step and the last uuid done, so an interrupted migration picks up where it left off on the next launch. Steps need to be idempotent: the checkpoint is written in the background, so the last batch may be redone.
+    struct Migration {
+        let name: String
+        let done: SMPersistItemBool
+        let checkpoint: SMPersistItemString
+        let steps: [Step]
+    }
+    
+    private enum BatchResult {
+        case more(lastUUID: String)
+        case stepDone
+        case failed
+    }
+    
+    private enum RunResult {
+        case done
+        case paused
+        case failed
+    }
+    
+    init(batchSize: Int = 500) {
+        self.batchSize = batchSize
+    }
+    
+    private var migrations: [Migration] {
+        func resetGoneAndReadProblem(objects: [FileObject]) {
+            objects.forEach { object in
+                object.gone = nil
+                object.readProblem = false
             }
-            
-            let images = ImageMediaObject.fetchAll()
-            images.forEach { image in
-                image.gone = nil
-                image.readProblem = false
+        }
+        
+        return [
+            Migration(name: "v0_18_3", done: Migrations.v0_18_3, checkpoint: Migrations.v0_18_3Checkpoint, steps: [
+                Step(entityName: DiscussionFileObject.entityName(), predicate: nil, migrate: resetGoneAndReadProblem),
+                Step(entityName: ImageMediaObject.entityName(), predicate: nil, migrate: resetGoneAndReadProblem)
+            ]),
+            Migration(name: "v1_5", done: Migrations.v1_5, checkpoint: Migrations.v1_5Checkpoint, steps: [
+                Step(entityName: ImageMediaObject.entityName(), predicate: NSPredicate(format: "discussion == nil"), migrate: { objects in
+                    Migrations.connectDiscussions(images: objects.compactMap {$0 as? ImageMediaObject})
+                })
+            ])
+        ]
+    }
+    
+    // Run this near or at the very end of the launch sequence in the app delegate-- so all of the setup is done. There's only work to do on the first launch after an update, and then this returns right away: the migrations run one batch per turn of the main queue, behind a blocking activity indicator, so launch time doesn't depend on the size of the library. `completion` is called on the main queue when they're done (or failed, to be tried again next launch). Start anything that changes objects-- syncing, and the albums screen, which syncs when it appears-- in `completion`, so it can't change objects part way through a migration. If the app is killed part way through, the next launch resumes from the checkpoint.
+    func launch(completion: @escaping ()->()) {
+        let pending = migrations.filter { !$0.done.boolValue }
+        guard pending.count > 0 else {
+            completion()
+            return
+        }
+        
+        Log.info("Migrations: Starting")
+        let size = CGSize(width: 50, height: 50)
+        NVActivityIndicatorPresenter.sharedInstance.startAnimating(ActivityData(size: size, message: "Updating...", type: .lineSpinFadeLoader))
+        
+        runBatches(migrations: pending) {
+            NVActivityIndicatorPresenter.sharedInstance.stopAnimating()
+            completion()
+        }
+    }
+    
+    private func runBatches(migrations: [Migration], completion: @escaping ()->()) {
+        DispatchQueue.main.async {
+            switch self.resume(migrations: migrations, maxBatches: 1) {
+            case .paused:
+                self.runBatches(migrations: migrations, completion: completion)
+            case .done, .failed:
+                completion()
             }
-            
-            CoreData.sessionNamed(CoreDataExtras.sessionName).saveContext()
+        }
+    }
+    
+    // Returns false if a migration didn't finish, because of a failure or after `maxBatches` batches. It resumes from its checkpoint the next time.
+    @discardableResult
+    func run(migrations: [Migration], maxBatches: Int = Int.max) -> Bool {
+        if case .done = resume(migrations: migrations, maxBatches: maxBatches) {
+            return true
         }
         
-        if !Migrations.v1_5.boolValue {
-            Migrations.v1_5.boolValue = true
+        return false
+    }
+    
+    private func resume(migrations: [Migration], maxBatches: Int) -> RunResult {
+        var batches = 0
+        
+        for migration in migrations where !migration.done.boolValue {
+            var (stepIndex, lastUUID) = Migrations.parse(checkpoint: migration.checkpoint.stringValue)
             
-            let images = ImageMediaObject.fetchAll()
-            for image in images {
-                guard image.discussion == nil else {
-                    // Not an error, just don't need to populate.
-                    continue
+            while stepIndex < migration.steps.count {
+                guard batches < maxBatches else {
+                    return .paused
                 }
+                batches += 1
                 
-                guard let fileGroupUUID = image.fileGroupUUID else {
-                    Log.error("No fileGroupUUID for image: \(String(describing: image.uuid))")
-                    continue
+                switch runBatch(step: migration.steps[stepIndex], after: lastUUID) {
+                case .failed:
+                    // Try again next launch.
+                    return .failed
+                case .more(let last):
+                    lastUUID = last
+                case .stepDone:
+                    stepIndex += 1
+                    lastUUID = ""
                 }
                 
-                guard let discussion = DiscussionFileObject.fetchObjectWithFileGroupUUID(fileGroupUUID) else {
-                    Log.error("Could not find discussion for image: fileGroupUUID: \(fileGroupUUID)")
-                    continue
-                }
+                migration.checkpoint.stringValue = "\(stepIndex)/\(lastUUID)"
                 
-                image.discussion = discussion
-                image.save()
+                // Otherwise the checkpoint isn't written until the main queue is free again.
+                SMPersistVars.session().flush()
+            }
+            
+            Log.info("Migration \(migration.name): Done")
+            migration.done.boolValue = true
+            migration.checkpoint.stringValue = ""
+        }
+        
+        return .done
+    }
+    
+    private func runBatch(step: Step, after lastUUID: String) -> BatchResult {
+        // Paging on uuid can't reach objects without one. There shouldn't be many; do them all at the start of the step.
+        let withoutUUID = NSPredicate(format: "%K == nil", "uuid")
+        if lastUUID.isEmpty {
+            guard let objects = fetch(step: step, predicate: withoutUUID, limit: 0) else {
+                return .failed
+            }
+            
+            migrate(objects: objects, step: step)
+        }
+        
+        guard let objects = fetch(step: step, predicate: NSPredicate(format: "%K > %@", "uuid", lastUUID), limit: batchSize) else {
+            return .failed
+        }
+        
+        guard let last = objects.last?.uuid else {
+            return .stepDone
+        }
+        
+        migrate(objects: objects, step: step)
+        
+        return objects.count < batchSize ? .stepDone : .more(lastUUID: last)
+    }
+    
+    // Objects of the step's entity, matching both its predicate and the given one, ordered by uuid. A limit of 0 means no limit.
+    private func fetch(step: Step, predicate: NSPredicate, limit: Int) -> [FileObject]? {
+        var predicates = [predicate]
+        if let predicate = step.predicate {
+            predicates += [predicate]
+        }
+        
+        do {
+            return try CoreData.sessionNamed(CoreDataExtras.sessionName).fetchObjects(withEntityName: step.entityName, modifyingFetchRequestWith: { fetchRequest in
+                fetchRequest.predicate = NSCompoundPredicate(andPredicateWithSubpredicates: predicates)
+                fetchRequest.sortDescriptors = [NSSortDescriptor(key: "uuid", ascending: true)]
+                fetchRequest.fetchLimit = limit
+                fetchRequest.returnsObjectsAsFaults = false
+            }) as? [FileObject] ?? []
+        } catch (let error) {
+            Log.error("Error: \(error)")
+            return nil
+        }
+    }
+    
+    private func migrate(objects: [FileObject], step: Step) {
+        guard objects.count > 0 else {
+            return
+        }
+        
+        let coreDataSession = CoreData.sessionNamed(CoreDataExtras.sessionName)
+        step.migrate(objects)
+        coreDataSession.saveContext()
+        
+        // Don't keep the whole store in memory as we go.
+        objects.forEach { object in
+            coreDataSession.context.refresh(object, mergeChanges: false)
+        }
+    }
+    
+    // A checkpoint is "<step index>/<last uuid done>".
+    private static func parse(checkpoint: String) -> (stepIndex: Int, lastUUID: String) {
+        let parts = checkpoint.split(separator: "/", maxSplits: 1, omittingEmptySubsequences: false)
+        guard parts.count == 2, let stepIndex = Int(parts[0]) else {
+            return (0, "")
+        }
+        
+        return (stepIndex, String(parts[1]))
+    }
+    
+    // Joins the images to their discussions by fileGroupUUID, with one fetch for the whole batch of images rather than one per image.
+    private static func connectDiscussions(images: [ImageMediaObject]) {
+        let fileGroupUUIDs = images.compactMap {$0.fileGroupUUID}
+        guard fileGroupUUIDs.count > 0 else {
+            return
+        }
+        
+        var discussions = [DiscussionFileObject]()
+        do {
+            discussions = try CoreData.sessionNamed(CoreDataExtras.sessionName).fetchObjects(withEntityName: DiscussionFileObject.entityName(), modifyingFetchRequestWith: { fetchRequest in
+                fetchRequest.predicate = NSPredicate(format: "%K IN %@", DiscussionFileObject.FILE_GROUP_UUID_KEY, fileGroupUUIDs)
+            }) as? [DiscussionFileObject] ?? []
+        } catch (let error) {
+            Log.error("Error: \(error)")
+            return
+        }
+        
+        var discussionsByFileGroup = [String: DiscussionFileObject](minimumCapacity: discussions.count)
+        discussions.forEach { discussion in
+            if let fileGroupUUID = discussion.fileGroupUUID {
+                discussionsByFileGroup[fileGroupUUID] = discussion
             }
         }
+        
+        for image in images {
+            guard let fileGroupUUID = image.fileGroupUUID else {
+                Log.error("No fileGroupUUID for image: \(String(describing: image.uuid))")
+                continue
+            }
+            
+            guard let discussion = discussionsByFileGroup[fileGroupUUID] else {
+                Log.error("Could not find discussion for image: fileGroupUUID: \(fileGroupUUID)")
+                continue
+            }
+            
+            image.discussion = discussion
+        }
     }
 }
@@ -15,26 +15,71 @@ import SyncServer_Shared
 
 @objc(ImageMediaObject)
 public class ImageMediaObject: FileMediaObject, FileMediaObjectProtocol {
+    // Sizes are recorded when the image is acquired or downloaded (see `setup(mediaData:)`), and for older images by `backfillOriginalSizes`. So this never touches the file system or saves the context-- it's used during collection view layout.
     var originalSize:CGSize? {
-        var originalImageSize = CGSize()
-
-        // Originally, I wasn't storing these sizes, so need to grab & store them here if we can. (Defaults for sizes are -1).
-        if originalWidth < 0 || originalHeight < 0 {
-            guard !readProblem, let url = url else {
+        guard originalWidth >= 0 && originalHeight >= 0 else {
+            return nil
+        }
+        
+        return CGSize(width: CGFloat(originalWidth), height: CGFloat(originalHeight))
+    }
+    
+    // Posted on the main thread when `backfillOriginalSizes` has stored sizes. Views laid out before then used a placeholder size for those images.
+    static let originalSizesBackfilled = Notification.Name("ImageMediaObject.originalSizesBackfilled")
+    
+    // Originally, I wasn't storing the sizes of images (defaults for sizes are -1). This reads the image headers for all such images, in parallel, off the main thread, and then stores the sizes with a single context save. Call on the main thread.
+    static func backfillOriginalSizes(completion: (()->())? = nil) {
+        var images = [ImageMediaObject]()
+        do {
+            images = try CoreData.sessionNamed(CoreDataExtras.sessionName).fetchObjects(withEntityName: entityName(), modifyingFetchRequestWith: { fetchRequest in
+                fetchRequest.predicate = NSPredicate(format: "(%K < 0) OR (%K < 0)", "originalWidth", "originalHeight")
+            }) as? [ImageMediaObject] ?? []
+        } catch (let error) {
+            Log.error("Error: \(error)")
+        }
+        
+        let toRead:[(objectID: NSManagedObjectID, url: URL)] = images.compactMap { image in
+            guard !image.readProblem, let url = image.url else {
                 return nil
             }
-            
-            originalImageSize = ImageExtras.sizeFromFile(url: url as URL)
-            originalWidth = Float(originalImageSize.width)
-            originalHeight = Float(originalImageSize.height)
-            CoreData.sessionNamed(CoreDataExtras.sessionName).saveContext()
+            return (image.objectID, url as URL)
         }
-        else {
-            originalImageSize.height = CGFloat(originalHeight)
-            originalImageSize.width = CGFloat(originalWidth)
+        
+        guard toRead.count > 0 else {
+            completion?()
+            return
         }
         
-        return originalImageSize
+        Log.info("Backfilling original sizes for \(toRead.count) image(s)")
+        
+        DispatchQueue.global(qos: .utility).async {
+            var sizes = [CGSize](repeating: .zero, count: toRead.count)
+            sizes.withUnsafeMutableBufferPointer { buffer in
+                DispatchQueue.concurrentPerform(iterations: toRead.count) { index in
+                    buffer[index] = ImageExtras.sizeFromFile(url: toRead[index].url)
+                }
+            }
+            
+            DispatchQueue.main.async {
+                let context = CoreData.sessionNamed(CoreDataExtras.sessionName).context
+                for (index, item) in toRead.enumerated() {
+                    let size = sizes[index]
+                    
+                    // Couldn't read the header; leave the size unknown.
+                    guard size != .zero,
+                        let image = (try? context.existingObject(with: item.objectID)) as? ImageMediaObject else {
+                        continue
+                    }
+                    
+                    image.originalWidth = Float(size.width)
+                    image.originalHeight = Float(size.height)
+                }
+                
+                CoreData.sessionNamed(CoreDataExtras.sessionName).saveContext()
+                NotificationCenter.default.post(name: ImageMediaObject.originalSizesBackfilled, object: nil)
+                completion?()
+            }
+        }
     }
 
     override class func entityName() -> String {
@@ -68,3 +68,49 @@ struct DiscussionMessage: MessageType {
         return formatter
     }()
 }
+
+// The messages of a discussion, decoded once from the FixedObjects. MessageKit asks for messages many times per cell, so this keeps scrolling from doing any dictionary conversion or date parsing.
+struct DiscussionMessages {
+    private(set) var messages = [DiscussionMessage]()
+    
+    // Parallel to `messages`: true iff the message is the first of its (local calendar) day.
+    private var firstOfDay = [Bool]()
+    
+    var count: Int {
+        return messages.count
+    }
+    
+    init() {
+    }
+    
+    // Fails if any fixed object isn't a valid message-- e.g., if the file format has changed.
+    init?(fixedObjects: FixedObjects) {
+        for fixedObject in fixedObjects {
+            guard let dict = fixedObject as? [String: String],
+                let message = DiscussionMessage.fromDictionary(dict) else {
+                return nil
+            }
+            
+            append(message)
+        }
+    }
+    
+    subscript(index: Int) -> DiscussionMessage {
+        return messages[index]
+    }
+    
+    func isFirstOfDay(at index: Int) -> Bool {
+        return firstOfDay[index]
+    }
+    
+    mutating func append(_ message: DiscussionMessage) {
+        if let previous = messages.last {
+            firstOfDay.append(!Calendar.current.isDate(message.sentDate, inSameDayAs: previous.sentDate))
+        }
+        else {
+            firstOfDay.append(true)
+        }
+        
+        messages.append(message)
+    }
+}
@@ -24,6 +24,7 @@ class DiscussionVC: MessagesViewController {
 
     private var fixedObjectsURL: URL!
     private var fixedObjects:FixedObjects!
+    private var messages = DiscussionMessages()
     var parentVC: UIViewController!
     private var closeHandler:(()->())?
     private var senderUserDisplayName:String!
@@ -69,15 +70,14 @@ class DiscussionVC: MessagesViewController {
             return false
         }
         
-        // Make sure that the file format containing the messages hasn't changed.
-        for fixedObject in fixedObjects {
-            guard let dict = fixedObject as? [String: String],
-                let _ = DiscussionMessage.fromDictionary(dict) else {
-                SMCoreLib.Alert.show(fromVC: parentVC, withTitle: "Problem loading messages", message: "Has there been a format change?")
-                return false
-            }
+        // This also makes sure that the file format containing the messages hasn't changed.
+        guard let messages = DiscussionMessages(fixedObjects: fixedObjects) else {
+            SMCoreLib.Alert.show(fromVC: parentVC, withTitle: "Problem loading messages", message: "Has there been a format change?")
+            return false
         }
         
+        self.messages = messages
+        
         return true
     }
     
@@ -149,6 +149,7 @@ class DiscussionVC: MessagesViewController {
         delegate?.discussionVC(self, discussion: discussion, refreshWithCompletion: {[weak self] in
             // 3/25/19; Made self references weak. Got a crash here.
             self?.loadDiscussion()
+            self?.warmMessageSizes()
             self?.messagesCollectionView.reloadData()
         })
     }
@@ -159,6 +160,7 @@ class DiscussionVC: MessagesViewController {
         // I can't get this to work in `viewWillAppear`. If it goes in `viewDidAppear`, I get the scrolling *after* the view appears, which doesn't look so good. Don't want it called more than once either.
         if !viewsLayedOut {
             viewsLayedOut = true
+            warmMessageSizes()
             messagesCollectionView.scrollToBottom()
         }
     }
@@ -177,6 +179,12 @@ class DiscussionVC: MessagesViewController {
         closeHandler?()
     }
     
+    // So that the layout, on inserts, keyboard changes etc., finds the text sizes of long discussions already measured. And so scrolling finds the link/phone/address matches already detected.
+    private func warmMessageSizes() {
+        (messagesCollectionView.collectionViewLayout as? MessagesCollectionViewFlowLayout)?.warmSizeCache(for: messages.messages)
+        MessageLabel.warmDetectorCache(for: messages.messages, detectors: DiscussionVC.detectors)
+    }
+    
     func getInitialsFromSenderDisplayName(sender: Sender) -> String {
         var initials = ""
         let usernameComponents = sender.displayName.components(separatedBy: " ")
@@ -192,6 +200,9 @@ class DiscussionVC: MessagesViewController {
 extension DiscussionVC: MessagesDisplayDelegate {
     // MARK: - Text Messages
 
+    // The same for all messages, so detector results can be found ahead of display.
+    static let detectors: [DetectorType] = [.url, .address, .phoneNumber, .date]
+
     func textColor(for message: MessageType, at indexPath: IndexPath, in messagesCollectionView: MessagesCollectionView) -> UIColor {
         return isFromCurrentSender(message: message) ? .white : .darkText
     }
@@ -201,7 +212,7 @@ extension DiscussionVC: MessagesDisplayDelegate {
     }
 
     func enabledDetectors(for message: MessageType, at indexPath: IndexPath, in messagesCollectionView: MessagesCollectionView) -> [DetectorType] {
-        return [.url, .address, .phoneNumber, .date]
+        return DiscussionVC.detectors
     }
 
     // MARK: - All Messages
@@ -268,36 +279,19 @@ extension DiscussionVC: MessagesLayoutDelegate {
 
 extension DiscussionVC: MessagesDataSource {
     func numberOfSections(in messagesCollectionView: MessagesCollectionView) -> Int {
-        return fixedObjects?.count ?? 0
+        return messages.count
     }
     
     func currentSender() -> Sender {        
         return Sender(id: senderUserId, displayName: senderUserDisplayName)
     }
 
-    private func messageForItem(at indexPath: IndexPath) -> MessageType {
-        // We've already checked to make sure the fixedObjects are valid.
-        let dict = fixedObjects![indexPath.section] as! [String: String]
-        let message = DiscussionMessage.fromDictionary(dict)!
-        
-        return message
-    }
-    
     func messageForItem(at indexPath: IndexPath, in messagesCollectionView: MessagesCollectionView) -> MessageType {
-        return messageForItem(at: indexPath)
+        return messages[indexPath.section]
     }
     
     private func isPreviousMessageSameDay(at indexPath: IndexPath) -> Bool {
-        guard indexPath.section - 1 >= 0 else { return false }
-        
-        let currentMessage = messageForItem(at: indexPath)
-        let currentMessageDate = currentMessage.sentDate
-        
-        let previousIndexPath = IndexPath(row: 0, section: indexPath.section - 1)
-        let previousMessage = messageForItem(at: previousIndexPath)
-        let previousMessageDate = previousMessage.sentDate
-        
-        return Calendar.current.isDate(currentMessageDate, inSameDayAs:previousMessageDate)
+        return !messages.isFirstOfDay(at: indexPath.section)
     }
     
     func cellTopLabelAttributedText(for message: MessageType, at indexPath: IndexPath) -> NSAttributedString? {
@@ -391,9 +385,11 @@ extension DiscussionVC: MessageInputBarDelegate {
                     try fixedObjects.save(toFile: fixedObjectsURL)
                 } catch (let error) {
                     SMCoreLib.Alert.show(fromVC: self, withTitle: "Alert!", message: "Failed adding message: \(error)")
+                    return
                 }
                 
-                messagesCollectionView.insertSections([fixedObjects.count - 1])
+                messages.append(message)
+                messagesCollectionView.insertSections([messages.count - 1])
                 
                 delegate.discussionVC(self, changedDiscussion: discussion)
             }
@@ -52,7 +52,13 @@ class DebugDashboardData {
             }
         })
         
-        return [resetTrackers]
+        let syncMetrics = RosterDevRowContents(name: "Sync metrics", action: { parentVC in
+            let scheduler = MediaHandler.session.syncController.scheduler
+            let metrics = scheduler.metrics
+            SMCoreLib.Alert.show(fromVC: parentVC, withTitle: "Sync metrics", message: "Syncs performed: \(metrics.syncsPerformed)\nSyncs with changes: \(metrics.syncsWithChanges)\nScheduled syncs: \(metrics.syncsByTrigger)\nCurrent interval: \(Int(scheduler.currentInterval))s")
+        })
+        
+        return [resetTrackers, syncMetrics]
     }()
     
     func sections() -> [[RosterDevRowContents]] {
@@ -95,13 +95,10 @@ class AlbumCollectionViewCell: UICollectionViewCell {
     }
     
     private func setSyncNeeded() {
-        let sharingGroups = SyncServer.session.sharingGroups
-        let filtered = sharingGroups.filter {$0.sharingGroupUUID == self.sharingGroup.sharingGroupUUID}
-        guard filtered.count == 1 else {
+        guard let sharingGroup = SyncServer.session.sharingGroupsSnapshot[self.sharingGroup.sharingGroupUUID] else {
             return
         }
         
-        let sharingGroup = filtered[0]
         albumSyncNeeded.isHidden = !sharingGroup.syncNeeded!
     }
     
@@ -203,7 +203,7 @@ class AlbumsVC: UIViewController, NVActivityIndicatorViewable {
     }
     
     private func updateSharingGroups() {
-        sharingGroups = SyncServer.session.sharingGroups
+        sharingGroups = SyncServer.session.sharingGroupsSnapshot.all
 
         sharingGroups.sort { sg1, sg2 in
             if let name1 = sg1.sharingGroupName, let name2 = sg2.sharingGroupName {
@@ -70,6 +70,14 @@ class LargeMediaVC : UIViewController {
         
         let backButton = UIBarButtonItem(image: #imageLiteral(resourceName: "back"), style: .plain, target: self, action: #selector(backAction))
         navigationItem.leftBarButtonItem = backButton
+        
+        NotificationCenter.default.addObserver(self, selector:#selector(originalSizesBackfilled), name:
+            ImageMediaObject.originalSizesBackfilled, object: nil)
+    }
+    
+    @objc private func originalSizesBackfilled() {
+        collectionView?.collectionViewLayout.invalidateLayout()
+        collectionView?.reloadData()
     }
     
     @objc private func backAction() {
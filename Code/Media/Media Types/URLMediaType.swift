@@ -57,6 +57,23 @@ extension URLMediaObject: MediaType {
     private static let URLKey = "URL"
     private static let titleKey = "TITLE"
     private static let imageTypeKey = "IMAGETYPE"
+    
+    private class ParsedURLFile {
+        let contents: URLFileContents
+        let modificationDate: Date
+        
+        init(contents: URLFileContents, modificationDate: Date) {
+            self.contents = contents
+            self.modificationDate = modificationDate
+        }
+    }
+    
+    // Keyed by file path. The modification date catches a file that's been replaced since it was parsed.
+    private static let parsedURLFiles: NSCache<NSString, ParsedURLFile> = {
+        let cache = NSCache<NSString, ParsedURLFile>()
+        cache.countLimit = 1000
+        return cache
+    }()
 
     // Creates a local .url file. Returns nil iff fails.
     static func createLocalURLFile(contents: URLFileContents) -> SMRelativeLocalURL? {
@@ -92,6 +109,29 @@ extension URLMediaObject: MediaType {
         return localFileURL
     }
     
+    // Like `parseURLFile`, but only reads and parses the file the first time it's asked for, or after it has changed. Safe to call from any thread.
+    static func urlFileContents(localURLFile: URL) -> URLFileContents? {
+        let key = localURLFile.path as NSString
+        let modificationDate = (try? FileManager.default.attributesOfItem(atPath: localURLFile.path))?[.modificationDate] as? Date
+        
+        if let modificationDate = modificationDate,
+            let parsed = parsedURLFiles.object(forKey: key),
+            parsed.modificationDate == modificationDate {
+            return parsed.contents
+        }
+        
+        guard let contents = parseURLFile(localURLFile: localURLFile) else {
+            parsedURLFiles.removeObject(forKey: key)
+            return nil
+        }
+        
+        if let modificationDate = modificationDate {
+            parsedURLFiles.setObject(ParsedURLFile(contents: contents, modificationDate: modificationDate), forKey: key)
+        }
+        
+        return contents
+    }
+    
     static func parseURLFile(localURLFile: URL) -> URLFileContents? {
         guard let fileData = try? Data(contentsOf: localURLFile) else {
             return nil
@@ -142,7 +182,7 @@ extension URLMediaObject: MediaType {
         for uuid in uuids {
             if let urlObj = URLMediaObject.fetchObjectWithUUID(uuid) {
                 if !urlObj.readProblem, let url = urlObj.url {
-                    if let contents = parseURLFile(localURLFile: url as URL) {
+                    if let contents = urlFileContents(localURLFile: url as URL) {
                         urlMedia += [contents.url]
                     }
                 }
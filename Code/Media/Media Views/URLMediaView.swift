@@ -19,6 +19,7 @@ class URLMediaView: UIView, MediaView {
     }
     
     private var linkPreview: LinkPreview!
+    private var previewImageRequest: LinkImageLoader.Request?
 
     private enum ContentType {
         case icon
@@ -59,6 +60,8 @@ class URLMediaView: UIView, MediaView {
         }
 
         content?.removeFromSuperview()
+        previewImageRequest?.cancel()
+        previewImageRequest = nil
         iconView = nil
         linkPreview = nil
         
@@ -89,14 +92,22 @@ class URLMediaView: UIView, MediaView {
         case .icon:
             iconView.linkIcon.isHidden = albumsView
             
-            if let previewImageURL = media.previewImage?.url,
-                let filePath = previewImageURL.path {
-                // TODO: Loading needs to be async
-                iconView?.image.image = UIImage(contentsOfFile: filePath)
-            }
-            else {
-                // No image; reset it so we don't have a lingering other image.
-                iconView?.image.image = nil
+            previewImageRequest?.cancel()
+            previewImageRequest = nil
+            
+            // Reset it so we don't have a lingering other image while loading, or if there's no image.
+            iconView?.image.image = nil
+            
+            if let previewImageURL = media.previewImage?.url {
+                // Decoded at the size shown, in the background; a memory cache hit calls back immediately. Before layout the frame is empty; icons are never shown larger than minimimPreviewSize, so decode at that.
+                var points = max(frameSize.width, frameSize.height)
+                if points <= 0 {
+                    points = minimimPreviewSize
+                }
+                let maxPixelSize = points * UIScreen.main.scale
+                previewImageRequest = LinkImageLoader.session.loadImage(for: previewImageURL as URL, maxPixelSize: maxPixelSize) { [weak self] image in
+                    self?.iconView?.image.image = image
+                }
             }
 
         case .preview:
@@ -104,8 +115,8 @@ class URLMediaView: UIView, MediaView {
                 return
             }
             
-            // TODO: Will want to make this file read async, especially when we get to loading image data from a file. And the image read below too.
-            guard let contents = URLMediaObject.parseURLFile(localURLFile: localMediaURL as URL) else {
+            // Parsed once per file, not each time the cell is shown.
+            guard let contents = URLMediaObject.urlFileContents(localURLFile: localMediaURL as URL) else {
                 return
             }
             
@@ -123,7 +134,7 @@ class URLMediaView: UIView, MediaView {
                 }
             }
             
-            // TODO: Have image loading from file in here. Need to make async.
+            // The preview loads its images in the background; setup cancels any load still pending from this view's previous media.
             let linkData = LinkData(url: contents.url, title: contents.title, description: nil, image: largeImageURL, icon: iconURL)
             linkPreview.setup(with: linkData)
             linkPreview.textAndIconAction = {[weak self] in
@@ -12,13 +12,15 @@ import NohanaImagePicker
 import Photos
 import SMCoreLib
 import SDCAlertView
+import ImageIO
+import MobileCoreServices
 
 public protocol AcquireImagesDelegate : class {
     // Called imediately before each image is acquired to obtain a URL for an image. A file shouldn't already exist at this URL when this returns.
     func acquireImagesURLForNewImage(_ acquireImages:AcquireImages) -> URL
 
-    // Called after all the images have been acquired.
-    func acquireImages(_ acquireImages:AcquireImages, images: [(newImageURL: URL, mimeType:String)])
+    // Called after all the images have been acquired. The size is the size of the image as displayed, i.e., after applying any EXIF orientation.
+    func acquireImages(_ acquireImages:AcquireImages, images: [(newImageURL: URL, mimeType:String, size: CGSize?)])
 }
 
 public class AcquireImages: NSObject {
@@ -27,6 +29,11 @@ public class AcquireImages: NSObject {
     // This should be a value between 0 and 1, with larger values giving higher quality, but larger files.
     open var compressionQuality:CGFloat = 0.5
     
+    // When a picked photo is already a JPEG, its original bytes are written to the file without decoding and re-encoding. That's only done if the photo fits within both of these limits; otherwise it gets downsampled (to `maxPassthroughPixelDimension`) and re-encoded with `compressionQuality`.
+    open var passthroughJPEG = true
+    open var maxPassthroughPixelDimension:CGFloat = 4096
+    open var maxPassthroughBytes:Int = 8 * 1024 * 1024
+    
     private weak var parentViewController:UIViewController!
     
     // Using this init method, you can then call the `acquire` method.
@@ -107,6 +114,105 @@ public class AcquireImages: NSObject {
         }
         return newFileURL
     }
+    
+    // Returns the size of the image, as displayed, iff write succeeds. Only reads the image header unless the image has to be re-encoded.
+    func write(imageData: Data, dataUTI: String?, to newFileURL: URL) -> CGSize? {
+        guard let source = CGImageSourceCreateWithData(imageData as CFData, nil),
+            let header = AcquireImages.header(of: source) else {
+            Log.error("Couldn't read image header!")
+            return nil
+        }
+        
+        let isJPEG = dataUTI.map {UTTypeConformsTo($0 as CFString, kUTTypeJPEG)} ?? false
+        let fitsBudget = max(header.pixelSize.width, header.pixelSize.height) <= maxPassthroughPixelDimension && imageData.count <= maxPassthroughBytes
+
+        if passthroughJPEG && isJPEG && fitsBudget {
+            // The EXIF orientation stays with the image, and UIImage applies it when the image is loaded.
+            guard let strippedData = AcquireImages.removingLocation(from: source) else {
+                Log.error("Couldn't remove location from image!")
+                return nil
+            }
+            
+            do {
+                try strippedData.write(to: newFileURL, options: .atomicWrite)
+            } catch {
+                Log.error("Error writing file: \(error)")
+                return nil
+            }
+            
+            return header.displayedSize
+        }
+        
+        // Downsample straight from the encoded data-- this applies the orientation and avoids a decode at full resolution.
+        let options: [CFString: Any] = [
+            kCGImageSourceCreateThumbnailFromImageAlways: true,
+            kCGImageSourceCreateThumbnailWithTransform: true,
+            kCGImageSourceShouldCacheImmediately: true,
+            kCGImageSourceThumbnailMaxPixelSize: min(maxPassthroughPixelDimension, max(header.pixelSize.width, header.pixelSize.height))
+        ]
+        
+        guard let cgImage = CGImageSourceCreateThumbnailAtIndex(source, 0, options as CFDictionary) else {
+            Log.error("Couldn't downsample image!")
+            return nil
+        }
+        
+        guard write(image: UIImage(cgImage: cgImage), to: newFileURL) else {
+            return nil
+        }
+        
+        return CGSize(width: cgImage.width, height: cgImage.height)
+    }
+    
+    private func writeImageDataToFile(imageData: Data, dataUTI: String?) -> (url: URL, size: CGSize)? {
+        let newFileURL = self.delegate?.acquireImagesURLForNewImage(self)
+        guard let size = write(imageData: imageData, dataUTI: dataUTI, to: newFileURL!) else {
+            return nil
+        }
+        return (newFileURL!, size)
+    }
+    
+    // Images are shared with other people in an album; don't share where they were taken. This copies the compressed image data as is-- it's not re-encoded-- and drops the GPS metadata, and the XMP metadata, which can also carry location.
+    static func removingLocation(from source: CGImageSource) -> Data? {
+        guard let type = CGImageSourceGetType(source) else {
+            return nil
+        }
+        
+        let data = NSMutableData()
+        guard let destination = CGImageDestinationCreateWithData(data as CFMutableData, type, 1, nil) else {
+            return nil
+        }
+        
+        let options: [CFString: Any] = [
+            kCGImageMetadataShouldExcludeGPS: true,
+            kCGImageMetadataShouldExcludeXMP: true
+        ]
+        
+        var error: Unmanaged<CFError>?
+        guard CGImageDestinationCopyImageSource(destination, source, options as CFDictionary, &error) else {
+            Log.error("Error copying image: \(String(describing: error?.takeRetainedValue()))")
+            return nil
+        }
+        
+        return data as Data
+    }
+    
+    private static func header(of source: CGImageSource) -> (pixelSize: CGSize, displayedSize: CGSize)? {
+        guard let properties = CGImageSourceCopyPropertiesAtIndex(source, 0, nil) as? [CFString: Any],
+            let width = properties[kCGImagePropertyPixelWidth] as? CGFloat,
+            let height = properties[kCGImagePropertyPixelHeight] as? CGFloat else {
+            return nil
+        }
+        
+        let pixelSize = CGSize(width: width, height: height)
+        
+        // EXIF orientations 5 through 8 rotate the image by 90 degrees.
+        let orientation = properties[kCGImagePropertyOrientation] as? Int ?? 1
+        if orientation >= 5 && orientation <= 8 {
+            return (pixelSize, CGSize(width: height, height: width))
+        }
+        
+        return (pixelSize, pixelSize)
+    }
 }
 
 extension AcquireImages: NohanaImagePickerControllerDelegate {
@@ -124,13 +230,13 @@ extension AcquireImages: NohanaImagePickerControllerDelegate {
         options.resizeMode = .exact
         options.isSynchronous = true
         
-        var result = [(newImageURL: URL, mimeType:String)]()
+        var result = [(newImageURL: URL, mimeType:String, size: CGSize?)]()
         
         for asset in pickedAssets {
-            imageManager.requestImageData(for: asset, options: options) { data, type, orientation, dict in
-                if let data = data, let image = UIImage(data: data),
-                    let newFileURL = self.writeImageToFile(image: image) {
-                    result += [(newFileURL, "image/jpeg")]
+            imageManager.requestImageData(for: asset, options: options) { data, dataUTI, orientation, dict in
+                if let data = data,
+                    let newFile = self.writeImageDataToFile(imageData: data, dataUTI: dataUTI) {
+                    result += [(newFile.url, "image/jpeg", newFile.size)]
                 }
             }
         }
@@ -150,7 +256,7 @@ extension AcquireImages : UIImagePickerControllerDelegate, UINavigationControlle
         }
         
         if let newFileURL = writeImageToFile(image: image) {
-            self.delegate.acquireImages(self, images: [(newImageURL: newFileURL, mimeType:"image/jpeg")])
+            self.delegate.acquireImages(self, images: [(newImageURL: newFileURL, mimeType:"image/jpeg", size: image.size)])
         }
         
         picker.dismiss(animated: true, completion: nil)
@@ -42,8 +42,18 @@ extension MediaVC {
         return (newMedia, newDiscussion)
     }
     
-    func createImageAndDiscussion(newImageURL: SMRelativeLocalURL, mimeType:String, userName: String?) -> (image: ImageMediaObject, discussion: DiscussionFileObject)? {
-        return createMediaAndDiscussion(newMediaURL: newImageURL, mimeType: mimeType, mediaType: ImageMediaObject.self, userName: userName, auxilaryFileMap: [:]) as? (ImageMediaObject, DiscussionFileObject)
+    // If given, the size is the one determined when the image was acquired, and is recorded as the original size of the image.
+    func createImageAndDiscussion(newImageURL: SMRelativeLocalURL, mimeType:String, userName: String?, size: CGSize? = nil) -> (image: ImageMediaObject, discussion: DiscussionFileObject)? {
+        guard let imageAndDiscussion = createMediaAndDiscussion(newMediaURL: newImageURL, mimeType: mimeType, mediaType: ImageMediaObject.self, userName: userName, auxilaryFileMap: [:]) as? (image: ImageMediaObject, discussion: DiscussionFileObject) else {
+            return nil
+        }
+        
+        if let size = size {
+            imageAndDiscussion.image.originalWidth = Float(size.width)
+            imageAndDiscussion.image.originalHeight = Float(size.height)
+        }
+        
+        return imageAndDiscussion
     }
     
     func createURLMediaAndDiscussion(newMediaURL: SMRelativeLocalURL, mimeType:String, userName: String?, auxilaryFileMap: [String: FixedObjects.ConvertableToJSON]) -> (urlMedia: URLMediaObject, discussion: DiscussionFileObject)? {
@@ -118,6 +118,9 @@ class MediaVC: UIViewController {
         NotificationCenter.default.addObserver(self, selector:#selector(setupHandlers), name:
             UIApplication.willEnterForegroundNotification, object: nil)
         
+        NotificationCenter.default.addObserver(self, selector:#selector(originalSizesBackfilled), name:
+            ImageMediaObject.originalSizesBackfilled, object: nil)
+        
         bottomRefresh = BottomRefresh(withScrollView: collectionView, scrollViewParent: view, refreshAction: { [unowned self] in
             Log.info("bottomRefresh: starting sync")
             do {
@@ -165,6 +168,16 @@ class MediaVC: UIViewController {
         mediaHandler.completedAddingOrUpdatingLocalMediaAction = completedAddingOrUpdatingLocalImages
     }
     
+    // Cells already laid out for these images have the placeholder size.
+    @objc private func originalSizesBackfilled() {
+        guard isViewLoaded else {
+            return
+        }
+        
+        collectionView.collectionViewLayout.invalidateLayout()
+        collectionView.reloadData()
+    }
+    
     @objc private func backAction() {
         navigationController?.popViewController(animated: true)
     }
@@ -440,7 +453,7 @@ extension MediaVC : AcquireImagesDelegate {
     }
     
     // TODO: Having problems showing alerts from here. Conflicting with possible present image capture screen.
-    func acquireImages(_ acquireImages: AcquireImages, images: [(newImageURL: URL, mimeType: String)]) {
+    func acquireImages(_ acquireImages: AcquireImages, images: [(newImageURL: URL, mimeType: String, size: CGSize?)]) {
         let userName = getUsername()
         var fileObjects = [FileObject]()
         
@@ -459,7 +472,7 @@ extension MediaVC : AcquireImagesDelegate {
                 return
             }
             
-            guard let imageAndDiscussion = createImageAndDiscussion(newImageURL: url, mimeType: newImage.mimeType, userName: userName) else {
+            guard let imageAndDiscussion = createImageAndDiscussion(newImageURL: url, mimeType: newImage.mimeType, userName: userName, size: newImage.size) else {
                 SMCoreLib.Alert.show(fromVC: self, withTitle: "Alert!", message: "Problem creating image and discussion!")
                 cleanup()
                 return
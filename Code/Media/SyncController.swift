@@ -74,8 +74,26 @@ class SyncController {
     let minIntervalBetweenErrorReports: TimeInterval = 60
     private var syncDone:(()->())?
     private var lastReportedErrorTime: Date?
-    let intervalBetweenPeriodicSyncs: TimeInterval = 60
-    var timer: Timer?
+    
+    // Periodic syncs across all albums, backing off while nothing is changing.
+    private(set) lazy var scheduler = SyncScheduler(startSync: {
+        guard !SyncServer.session.isSyncing && SignInManager.session.userIsSignedIn else {
+            return false
+        }
+        
+        do {
+            try SyncServer.session.sync()
+        } catch (let error) {
+            Log.error("\(error)")
+            return false
+        }
+        
+        return true
+    })
+    
+    // Whether the current sync changed anything locally. The index sync doesn't download files, so new content shows up as albums newly needing a sync.
+    private var syncFoundChanges = false
+    private var syncNeededAtStart = Set<String>()
 
     init() {
         SyncServer.session.delegate = self
@@ -96,6 +114,9 @@ class SyncController {
     // Not called on app initial launch.
     func appWillEnterForeground() {
         startPeriodicSync()
+        
+        // Things have likely changed while we were in the background.
+        scheduler.syncSoon(trigger: .foreground)
     }
     
     func appDidEnterBackground() {
@@ -104,22 +125,16 @@ class SyncController {
 
     @objc private func startPeriodicSync() {
         Log.info("startPeriodicSync")
-        timer?.invalidate()
-        timer = Timer.scheduledTimer(withTimeInterval: intervalBetweenPeriodicSyncs, repeats: true) { _ in
-            if !SyncServer.session.isSyncing && SignInManager.session.userIsSignedIn {
-                Log.info("startPeriodicSync: sync")
-                do {
-                    try SyncServer.session.sync()
-                } catch (let error) {
-                    Log.error("\(error)")
-                }
-            }
-        }
+        scheduler.start()
     }
 
     @objc private func stopPeriodicSync() {
-        timer?.invalidate()
-        timer = nil
+        scheduler.stop()
+    }
+    
+    // Some album probably has new content.
+    func pushNotificationReceived() {
+        scheduler.syncSoon(trigger: .pushNotification)
     }
     
     weak var delegate:SyncControllerDelegate!
@@ -127,6 +142,7 @@ class SyncController {
     
     func sync(sharingGroupUUID: String, completion: (()->())? = nil) throws {
         syncDone = completion
+        scheduler.localChange()
         Log.info("About to do SyncController.sync sync")
         try SyncServer.session.sync(sharingGroupUUID: sharingGroupUUID)
     }
@@ -138,6 +154,7 @@ class SyncController {
         }
         
         let sharingGroupUUID = objects[0].sharingGroupUUID!
+        scheduler.localChange()
         
         guard queueFileObjects(objects: objects) else {
             errorCleanup()
@@ -233,6 +250,7 @@ class SyncController {
         }
         
         let discussionAttr = SyncAttributes(fileUUID:discussion.uuid!, sharingGroupUUID: discussion.sharingGroupUUID!, mimeType:discussionMimeTypeEnum)
+        scheduler.localChange()
         
         do {
             // Like before, since discussions are mutable, use uploadCopy.
@@ -264,6 +282,7 @@ class SyncController {
 
         let description = MediaTypeExtras.namesFor(media: media, includeCounts: true)
         let pushNotificationMessage = "Removed \(description)."
+        scheduler.localChange()
         
         do {
             try SyncServer.session.delete(filesWithUUIDs: mediaUuids + discussionUuids + auxilaryUUIDs)
@@ -279,6 +298,10 @@ class SyncController {
 
 extension SyncController : SyncServerDelegate {
     func syncServerSharingGroupsDownloaded(created: [SyncServer.SharingGroup], updated: [SyncServer.SharingGroup], deleted: [SyncServer.SharingGroup]) {
+        if !created.isEmpty || !updated.isEmpty || !deleted.isEmpty {
+            syncFoundChanges = true
+        }
+        
         deleted.forEach { album in
             delegate.userRemovedFromAlbum(syncController: self, sharingGroup: album)
         }
@@ -564,6 +587,7 @@ extension SyncController : SyncServerDelegate {
         let syncServerError = "Server error occurred: \(error)"
         Log.error(syncServerError)
         turnIdleTimerOn()
+        scheduler.syncFailed()
         
         // Because these errors (a) result in UI prompts, and (b) we don't want too frequent of UI prompts, make sure there are not too many close together in time.
         let currErrorTime = Date()
@@ -637,6 +661,8 @@ extension SyncController : SyncServerDelegate {
             // turnIdleTimerOff()
             
             numberOperations = 0
+            syncFoundChanges = false
+            syncNeededAtStart = Set(SyncServer.session.sharingGroups.filter {$0.syncNeeded!}.map {$0.sharingGroupUUID})
             delegate.syncEvent(syncController: self, event: .syncStarted)
             
         case .serverDown(message: let message):
@@ -739,6 +765,9 @@ extension SyncController : SyncServerDelegate {
             let syncNeeded = SyncServer.session.sharingGroups.filter {$0.syncNeeded!}
             AppBadge.setBadge(number: syncNeeded.count)
             
+            let newlySyncNeeded = Set(syncNeeded.map {$0.sharingGroupUUID}).subtracting(syncNeededAtStart)
+            scheduler.syncCompleted(foundChanges: syncFoundChanges || numberOperations > 0 || !newlySyncNeeded.isEmpty)
+            
             delegate.syncEvent(syncController: self, event: .syncDone(numberOperations: numberOperations))
             syncDone?()
             syncDone = nil
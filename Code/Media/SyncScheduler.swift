@@ -0,0 +1,186 @@
+//
+//  SyncScheduler.swift
+//  SharedImages
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import Foundation
+import SMCoreLib
+
+// Decides when to do the background sync across all albums. Instead of polling every minute, the interval between idle syncs doubles each time a sync finds nothing new, up to `maximumInterval`, and drops back to `minimumInterval` as soon as something changes. Push notifications, local changes and coming to the foreground bring the next sync forward; requests that arrive close together (e.g., several pushes for different albums) coalesce into a single sync.
+class SyncScheduler {
+    enum Trigger: String {
+        case idle
+        case pushNotification
+        case localChange
+        case foreground
+    }
+
+    struct Metrics {
+        var syncsPerformed = 0
+        var syncsWithChanges = 0
+        var syncsByTrigger = [String: Int]()
+    }
+
+    let minimumInterval: TimeInterval
+    let maximumInterval: TimeInterval
+    let backoffFactor: Double = 2
+
+    // Fraction of the interval by which a scheduled sync is randomly moved earlier or later, so that devices don't sync in lockstep.
+    let jitter: Double = 0.2
+
+    // How long to wait, after a push notification or foregrounding, for other requests to coalesce with.
+    let coalescingDelay: TimeInterval = 2
+
+    private(set) var currentInterval: TimeInterval
+    private(set) var metrics = Metrics()
+
+    private var timer: Timer?
+    private var fireDate: Date?
+    private var pendingTrigger: Trigger = .idle
+    private var running = false
+
+    // Non-nil while a sync started by the scheduler is in progress.
+    private var inProgressTrigger: Trigger?
+
+    // Starts a sync, returning false if it couldn't be started (e.g., one is already in progress).
+    private let startSync: ()->(Bool)
+
+    init(minimumInterval: TimeInterval = 60, maximumInterval: TimeInterval = 30 * 60, startSync: @escaping ()->(Bool)) {
+        self.minimumInterval = minimumInterval
+        self.maximumInterval = maximumInterval
+        self.startSync = startSync
+        currentInterval = minimumInterval
+    }
+
+    func start() {
+        running = true
+        schedule(after: currentInterval, trigger: .idle)
+    }
+
+    func stop() {
+        running = false
+        timer?.invalidate()
+        timer = nil
+        fireDate = nil
+    }
+
+    // Bring the next sync forward to within `coalescingDelay`. Doesn't push back a sync that's already due sooner.
+    func syncSoon(trigger: Trigger) {
+        currentInterval = minimumInterval
+        guard running else {
+            return
+        }
+
+        schedule(after: coalescingDelay, trigger: trigger)
+    }
+
+    // The user is doing something that syncs on its own (e.g., uploading to an album); don't sync across albums right away, but don't back off either.
+    func localChange() {
+        currentInterval = minimumInterval
+        guard running else {
+            return
+        }
+
+        schedule(after: currentInterval, trigger: .localChange)
+    }
+
+    // Call for every completed sync, whether or not the scheduler started it.
+    func syncCompleted(foundChanges: Bool) {
+        metrics.syncsPerformed += 1
+        if foundChanges {
+            metrics.syncsWithChanges += 1
+        }
+
+        let trigger = inProgressTrigger
+        inProgressTrigger = nil
+
+        // Only our own syncs adjust the backoff when they find nothing; any sync that finds something means things are active.
+        if foundChanges || trigger != nil {
+            currentInterval = SyncScheduler.nextInterval(after: currentInterval, foundChanges: foundChanges, minimum: minimumInterval, maximum: maximumInterval, factor: backoffFactor)
+        }
+
+        Log.info("SyncScheduler: trigger: \(String(describing: trigger)); foundChanges: \(foundChanges); next interval: \(currentInterval); syncs: \(metrics.syncsPerformed); with changes: \(metrics.syncsWithChanges)")
+
+        if running {
+            // A completed sync makes any earlier-scheduled idle sync redundant.
+            timer?.invalidate()
+            timer = nil
+            fireDate = nil
+            schedule(after: currentInterval, trigger: .idle)
+        }
+    }
+
+    // Call when a sync ends in an error, whether or not the scheduler started it. There's no syncCompleted for such a sync, so this schedules the next one. Backs off as for a sync that found nothing, so a persistent failure (e.g., no network) isn't retried every minute.
+    func syncFailed() {
+        let trigger = inProgressTrigger
+        inProgressTrigger = nil
+
+        currentInterval = SyncScheduler.nextInterval(after: currentInterval, foundChanges: false, minimum: minimumInterval, maximum: maximumInterval, factor: backoffFactor)
+
+        Log.info("SyncScheduler: failed; trigger: \(String(describing: trigger)); next interval: \(currentInterval)")
+
+        if running {
+            // Keeps a sync that's already due sooner.
+            schedule(after: currentInterval, trigger: .idle)
+        }
+    }
+
+    static func nextInterval(after current: TimeInterval, foundChanges: Bool, minimum: TimeInterval, maximum: TimeInterval, factor: Double) -> TimeInterval {
+        if foundChanges {
+            return minimum
+        }
+        return min(max(current * factor, minimum), maximum)
+    }
+
+    // `random` is in [0, 1).
+    static func jittered(_ interval: TimeInterval, jitter: Double, random: Double = Double.random(in: 0..<1)) -> TimeInterval {
+        return interval * (1 + jitter * (2 * random - 1))
+    }
+
+    private func schedule(after interval: TimeInterval, trigger: Trigger) {
+        let delay = SyncScheduler.jittered(interval, jitter: jitter)
+        let date = Date(timeIntervalSinceNow: delay)
+
+        if let fireDate = fireDate, fireDate <= date {
+            // Already due sooner; coalesce, keeping the more specific reason.
+            if pendingTrigger == .idle {
+                pendingTrigger = trigger
+            }
+            return
+        }
+
+        timer?.invalidate()
+        pendingTrigger = trigger
+        fireDate = date
+        timer = Timer.scheduledTimer(withTimeInterval: delay, repeats: false) { [weak self] _ in
+            self?.fire()
+        }
+
+        // Let the system batch our wakeups with others; the jitter already makes exact timing moot.
+        timer?.tolerance = delay * jitter / 2
+    }
+
+    private func fire() {
+        let trigger = pendingTrigger
+        timer = nil
+        fireDate = nil
+        pendingTrigger = .idle
+
+        guard running else {
+            return
+        }
+
+        if startSync() {
+            inProgressTrigger = trigger
+            metrics.syncsByTrigger[trigger.rawValue, default: 0] += 1
+            Log.info("SyncScheduler: sync; trigger: \(trigger)")
+        }
+        else {
+            // Something else is syncing; we'll hear about it in syncCompleted. In case we don't, try again later.
+            schedule(after: currentInterval, trigger: trigger)
+        }
+    }
+}
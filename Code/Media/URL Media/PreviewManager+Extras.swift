@@ -32,6 +32,7 @@ extension PreviewManager {
         PreviewManager.session.add(source: adaPreview)
         PreviewManager.session.add(source: mPreview)
         
-        PreviewManager.session.config = PreviewConfiguration(maxNumberTitleLines: 3)
+        // Microsoft's preview is the best, but can be slow; don't let it hold up the others for long.
+        PreviewManager.session.config = PreviewConfiguration(maxNumberTitleLines: 3, providerStrategy: .hedged(delay: 1.5))
     }
 }
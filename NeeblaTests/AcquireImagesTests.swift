@@ -0,0 +1,114 @@
+//
+//  AcquireImagesTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+@testable import Neebla
+import MobileCoreServices
+
+class AcquireImagesTests: XCTestCase {
+    var jpegData: Data!
+    var fileURL: URL!
+    let imageSize = CGSize(width: 3024, height: 4032)
+    
+    override func setUp() {
+        super.setUp()
+        
+        let format = UIGraphicsImageRendererFormat()
+        format.scale = 1
+        let renderer = UIGraphicsImageRenderer(size: imageSize, format: format)
+        let image = renderer.image { context in
+            UIColor.blue.setFill()
+            context.fill(CGRect(origin: .zero, size: imageSize))
+            UIColor.yellow.setFill()
+            context.fill(CGRect(x: 100, y: 100, width: 1000, height: 2000))
+        }
+        
+        jpegData = image.jpegData(compressionQuality: 0.8)
+        fileURL = FileManager.default.temporaryDirectory.appendingPathComponent("AcquireImagesTests.jpg")
+    }
+    
+    override func tearDown() {
+        try? FileManager.default.removeItem(at: fileURL)
+        super.tearDown()
+    }
+    
+    func testPassthroughKeepsFullSizeImage() {
+        let acquireImages = AcquireImages()
+        guard let size = acquireImages.write(imageData: jpegData, dataUTI: kUTTypeJPEG as String, to: fileURL) else {
+            XCTFail()
+            return
+        }
+        
+        XCTAssert(size == imageSize)
+        
+        let written = UIImage(contentsOfFile: fileURL.path)
+        XCTAssert(written?.cgImage?.width == Int(imageSize.width))
+        XCTAssert(written?.cgImage?.height == Int(imageSize.height))
+    }
+    
+    func testPassthroughRemovesLocation() {
+        guard let source = CGImageSourceCreateWithData(jpegData as CFData, nil) else {
+            XCTFail()
+            return
+        }
+        
+        let gps: [CFString: Any] = [
+            kCGImagePropertyGPSLatitude: 37.33,
+            kCGImagePropertyGPSLatitudeRef: "N",
+            kCGImagePropertyGPSLongitude: 122.03,
+            kCGImagePropertyGPSLongitudeRef: "W"
+        ]
+        
+        let withGPS = NSMutableData()
+        guard let destination = CGImageDestinationCreateWithData(withGPS as CFMutableData, kUTTypeJPEG, 1, nil) else {
+            XCTFail()
+            return
+        }
+        CGImageDestinationAddImageFromSource(destination, source, 0, [kCGImagePropertyGPSDictionary: gps] as CFDictionary)
+        XCTAssert(CGImageDestinationFinalize(destination))
+        
+        let acquireImages = AcquireImages()
+        guard acquireImages.write(imageData: withGPS as Data, dataUTI: kUTTypeJPEG as String, to: fileURL) != nil,
+            let written = CGImageSourceCreateWithURL(fileURL as CFURL, nil),
+            let properties = CGImageSourceCopyPropertiesAtIndex(written, 0, nil) as? [CFString: Any] else {
+            XCTFail()
+            return
+        }
+        
+        XCTAssert(properties[kCGImagePropertyGPSDictionary] == nil)
+    }
+    
+    func testOverBudgetImageIsDownsampled() {
+        let acquireImages = AcquireImages()
+        acquireImages.maxPassthroughPixelDimension = 1000
+        guard let size = acquireImages.write(imageData: jpegData, dataUTI: kUTTypeJPEG as String, to: fileURL) else {
+            XCTFail()
+            return
+        }
+        
+        XCTAssert(max(size.width, size.height) == 1000)
+        XCTAssert(try Data(contentsOf: fileURL) != jpegData)
+    }
+    
+    // Ingest time per photo: passthrough vs. the prior decode/re-encode of each photo.
+    func testPassthroughIngestPerformance() {
+        let acquireImages = AcquireImages()
+        measure {
+            _ = acquireImages.write(imageData: jpegData, dataUTI: kUTTypeJPEG as String, to: fileURL)
+        }
+    }
+    
+    func testReencodeIngestPerformance() {
+        let acquireImages = AcquireImages()
+        measure {
+            if let image = UIImage(data: jpegData) {
+                _ = acquireImages.write(image: image, to: fileURL)
+            }
+        }
+    }
+}
@@ -0,0 +1,95 @@
+//
+//  BFExecutorTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import Bolts
+
+// Benchmarks for wide and deep task graphs, comparing the default and work-stealing executors.
+class BFExecutorTests: XCTestCase {
+    let width = 100000
+    let depth = 100000
+    
+    // Fans out `width` independent continuations, and waits for all of them.
+    func runWideGraph(executor: BFExecutor) {
+        let source = BFTaskCompletionSource<AnyObject>()
+        var tasks = [BFTask<AnyObject>]()
+        tasks.reserveCapacity(width)
+        
+        for index in 0..<width {
+            tasks += [source.task.continueWith(executor: executor) { _ in
+                return NSNumber(value: index)
+            }]
+        }
+        
+        source.set(result: nil)
+        let all = BFTask<AnyObject>(forCompletionOfAllTasks: tasks)
+        all.waitUntilFinished()
+        XCTAssert(all.isCompleted && !all.isFaulted)
+    }
+    
+    // A chain of `depth` continuations, each depending on the one before it.
+    func runDeepGraph(executor: BFExecutor) {
+        let source = BFTaskCompletionSource<AnyObject>()
+        var task = source.task
+        
+        for _ in 0..<depth {
+            task = task.continueWith(executor: executor) { previous in
+                let count = (previous.result as? NSNumber)?.intValue ?? 0
+                return NSNumber(value: count + 1)
+            }
+        }
+        
+        source.set(result: NSNumber(value: 0))
+        task.waitUntilFinished()
+        XCTAssert((task.result as? NSNumber)?.intValue == depth)
+    }
+    
+    func testWorkStealingRunsEveryBlock() {
+        let count = 1000
+        let group = DispatchGroup()
+        let counter = NSLock()
+        var ran = 0
+        
+        for _ in 0..<count {
+            group.enter()
+            BFExecutor.workStealing().execute {
+                counter.lock()
+                ran += 1
+                counter.unlock()
+                group.leave()
+            }
+        }
+        
+        XCTAssert(group.wait(timeout: .now() + 10) == .success)
+        XCTAssert(ran == count)
+    }
+    
+    func testWideGraphDefaultExecutor() {
+        measure {
+            runWideGraph(executor: BFExecutor.default())
+        }
+    }
+    
+    func testWideGraphWorkStealingExecutor() {
+        measure {
+            runWideGraph(executor: BFExecutor.workStealing())
+        }
+    }
+    
+    func testDeepGraphDefaultExecutor() {
+        measure {
+            runDeepGraph(executor: BFExecutor.default())
+        }
+    }
+    
+    func testDeepGraphWorkStealingExecutor() {
+        measure {
+            runDeepGraph(executor: BFExecutor.workStealing())
+        }
+    }
+}
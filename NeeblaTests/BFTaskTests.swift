@@ -0,0 +1,200 @@
+//
+//  BFTaskTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import Bolts
+
+class BFTaskTests: XCTestCase {
+    func testContinuationsRunInOrderAdded() {
+        let source = BFTaskCompletionSource<NSNumber>()
+        var order = [Int]()
+        for index in 0..<10 {
+            source.task.continueWith(executor: BFExecutor.immediate()) { _ in
+                order.append(index)
+                return nil
+            }
+        }
+        source.set(result: 1)
+        XCTAssert(order == Array(0..<10))
+    }
+    
+    func testOnlyFirstCompletionWins() {
+        let source = BFTaskCompletionSource<NSNumber>()
+        var wins = 0
+        let winsLock = NSLock()
+        
+        DispatchQueue.concurrentPerform(iterations: 100) { index in
+            if source.trySet(result: NSNumber(value: index)) {
+                winsLock.lock()
+                wins += 1
+                winsLock.unlock()
+            }
+        }
+        
+        XCTAssert(wins == 1)
+        XCTAssert(source.task.isCompleted)
+        XCTAssert(!source.task.isFaulted && !source.task.isCancelled)
+    }
+    
+    func testWaitUntilFinished() {
+        let source = BFTaskCompletionSource<NSNumber>()
+        DispatchQueue.global().asyncAfter(deadline: .now() + 0.1) {
+            source.set(result: 1)
+        }
+        source.task.waitUntilFinished()
+        XCTAssert(source.task.result?.intValue == 1)
+    }
+    
+    func testCompletionOfAllTasksCollectsErrors() {
+        let sources = (0..<3).map { _ in BFTaskCompletionSource<NSNumber>() }
+        let all = BFTask<NSNumber>(forCompletionOfAllTasks: sources.map { $0.task })
+        
+        sources[0].set(result: 1)
+        sources[1].set(error: NSError(domain: "BFTaskTests", code: 1, userInfo: nil))
+        sources[2].cancel()
+        all.waitUntilFinished()
+        
+        XCTAssert(all.isFaulted)
+        XCTAssert((all.error as NSError?)?.code == 1)
+    }
+    
+    // A completion on another thread racing with waitUntilFinished mustn't leave the waiter asleep.
+    func testWaitUntilFinishedRacingCompletion() {
+        let finished = expectation(description: "waits")
+        DispatchQueue.global().async {
+            for index in 0..<10000 {
+                let source = BFTaskCompletionSource<NSNumber>()
+                DispatchQueue.global().async {
+                    source.set(result: NSNumber(value: index))
+                }
+                source.task.waitUntilFinished()
+            }
+            finished.fulfill()
+        }
+        waitForExpectations(timeout: 60, handler: nil)
+    }
+    
+    // Contention: 1M tasks, each continued and completed from two threads at once. Worker w works through its own
+    // stripe of the tasks and the next worker's, in step, so every task is touched by two workers together: each
+    // adds a continuation and tries to complete it, and one of them wins.
+    private func runContended<TaskType: ContendedTask>(_ taskType: TaskType.Type) {
+        let numberOfTasks = 1_000_000
+        let batchSize = 10_000
+        let workers = max(ProcessInfo.processInfo.activeProcessorCount, 2)
+        let tasksPerStripe = batchSize / workers
+        
+        let continuationsRun = UnsafeMutablePointer<Int32>.allocate(capacity: 1)
+        let wins = UnsafeMutablePointer<Int32>.allocate(capacity: 1)
+        continuationsRun.initialize(to: 0)
+        wins.initialize(to: 0)
+        defer {
+            continuationsRun.deallocate()
+            wins.deallocate()
+        }
+        
+        var completed = 0
+        while completed < numberOfTasks {
+            let tasks = (0..<tasksPerStripe * workers).map { _ in TaskType() }
+            DispatchQueue.concurrentPerform(iterations: workers) { worker in
+                let stripes = [worker, (worker + 1) % workers]
+                for index in 0..<tasksPerStripe {
+                    for stripe in stripes {
+                        let task = tasks[index * workers + stripe]
+                        task.addContinuation {
+                            OSAtomicIncrement32Barrier(continuationsRun)
+                        }
+                        if task.trySetResult(NSNumber(value: index)) {
+                            OSAtomicIncrement32Barrier(wins)
+                        }
+                    }
+                }
+            }
+            completed += tasks.count
+        }
+        
+        XCTAssert(wins.pointee == Int32(completed), "\(wins.pointee)")
+        XCTAssert(continuationsRun.pointee == Int32(2 * completed), "\(continuationsRun.pointee)")
+    }
+    
+    func testCompletionContention() {
+        measure {
+            runContended(BoltsTask.self)
+        }
+    }
+    
+    // The baseline for testCompletionContention: the same work, with tasks locked as BFTask's were before it was lock free.
+    func testCompletionContentionLockedBaseline() {
+        measure {
+            runContended(LockedTask.self)
+        }
+    }
+}
+
+protocol ContendedTask {
+    init()
+    func addContinuation(_ block: @escaping () -> ())
+    func trySetResult(_ result: NSNumber) -> Bool
+}
+
+final class BoltsTask: ContendedTask {
+    private let source = BFTaskCompletionSource<NSNumber>()
+    
+    func addContinuation(_ block: @escaping () -> ()) {
+        source.task.continueWith(executor: BFExecutor.immediate()) { _ in
+            block()
+            return nil
+        }
+    }
+    
+    func trySetResult(_ result: NSNumber) -> Bool {
+        return source.trySet(result: result)
+    }
+}
+
+// How BFTask was synchronized before: @synchronized on every access, a condition per task, and an array of callbacks run holding the lock.
+final class LockedTask: ContendedTask {
+    private let lock = NSObject()
+    private let condition = NSCondition()
+    private var callbacks = [() -> ()]()
+    private var completed = false
+    private var result: NSNumber?
+    
+    func addContinuation(_ block: @escaping () -> ()) {
+        objc_sync_enter(lock)
+        defer { objc_sync_exit(lock) }
+        
+        if completed {
+            block()
+        }
+        else {
+            callbacks.append(block)
+        }
+    }
+    
+    func trySetResult(_ result: NSNumber) -> Bool {
+        objc_sync_enter(lock)
+        defer { objc_sync_exit(lock) }
+        
+        if completed {
+            return false
+        }
+        
+        completed = true
+        self.result = result
+        
+        condition.lock()
+        condition.broadcast()
+        condition.unlock()
+        
+        for callback in callbacks {
+            callback()
+        }
+        callbacks.removeAll()
+        return true
+    }
+}
@@ -0,0 +1,183 @@
+//
+//  BatchUploadTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+@testable import SwiftyDropbox
+
+// Stands in for the Dropbox upload_session endpoints, answering after `latency`. Tracks how many upload sessions are open at once.
+class DropboxUploadStub: URLProtocol {
+    static let host = "dropbox.stub"
+    static var latency: TimeInterval = 0.05
+
+    private static let lock = NSLock()
+    private static var openSessions = 0
+    private(set) static var maxOpenSessions = 0
+    private(set) static var sessionsStarted = 0
+
+    static func reset() {
+        lock.lock()
+        openSessions = 0
+        maxOpenSessions = 0
+        sessionsStarted = 0
+        lock.unlock()
+    }
+
+    override class func canInit(with request: URLRequest) -> Bool {
+        return request.url?.host == host
+    }
+
+    override class func canonicalRequest(for request: URLRequest) -> URLRequest {
+        return request
+    }
+
+    override func startLoading() {
+        let path = request.url?.path ?? ""
+        var arg = [String: Any]()
+        if let header = request.value(forHTTPHeaderField: "Dropbox-API-Arg"),
+            let json = try? JSONSerialization.jsonObject(with: Data(header.utf8)) as? [String: Any] {
+            arg = json
+        }
+        let close = arg["close"] as? Bool ?? false
+
+        // append_v2 has no result.
+        var body: Any?
+        DropboxUploadStub.lock.lock()
+        if path.hasSuffix("/upload_session/start") {
+            DropboxUploadStub.sessionsStarted += 1
+            body = ["session_id": "session\(DropboxUploadStub.sessionsStarted)"]
+            if !close {
+                DropboxUploadStub.openSessions += 1
+                DropboxUploadStub.maxOpenSessions = max(DropboxUploadStub.maxOpenSessions, DropboxUploadStub.openSessions)
+            }
+        }
+        else if path.hasSuffix("/upload_session/append_v2") {
+            if close {
+                DropboxUploadStub.openSessions -= 1
+            }
+        }
+        else if path.hasSuffix("/upload_session/finish_batch") {
+            body = [".tag": "async_job_id", "async_job_id": "job"]
+        }
+        else if path.hasSuffix("/upload_session/finish_batch/check") {
+            let entries = (0..<DropboxUploadStub.sessionsStarted).map { index in
+                return [".tag": "success", "name": "file\(index)", "id": "id:\(index)", "client_modified": "2019-10-19T00:00:00Z", "server_modified": "2019-10-19T00:00:00Z", "rev": "0123456789abcdef", "size": 0]
+            }
+            body = [".tag": "complete", "entries": entries]
+        }
+        DropboxUploadStub.lock.unlock()
+
+        let data = body.map { try! JSONSerialization.data(withJSONObject: $0) } ?? Data("null".utf8)
+        let response = HTTPURLResponse(url: request.url!, statusCode: 200, httpVersion: "HTTP/1.1", headerFields: ["Content-Type": "application/json"])!
+
+        DispatchQueue.global().asyncAfter(deadline: .now() + DropboxUploadStub.latency) {
+            self.client?.urlProtocol(self, didReceive: response, cacheStoragePolicy: .notAllowed)
+            self.client?.urlProtocol(self, didLoad: data)
+            self.client?.urlProtocolDidFinishLoading(self)
+        }
+    }
+
+    override func stopLoading() {
+    }
+}
+
+class BatchUploadTests: XCTestCase {
+    // Each file is just over one chunk, so it takes an upload_session/start and one append.
+    let numberOfFiles = 12
+    var directory: URL!
+    var files = [URL]()
+    var client: DropboxClient!
+
+    override func setUp() {
+        super.setUp()
+        DropboxUploadStub.reset()
+
+        directory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        try! FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true, attributes: nil)
+
+        // Sparse; they take next to no space on disk.
+        files = (0..<numberOfFiles).map { index in
+            let url = directory.appendingPathComponent("file\(index)")
+            FileManager.default.createFile(atPath: url.path, contents: nil, attributes: nil)
+            let fileHandle = try! FileHandle(forWritingTo: url)
+            fileHandle.truncateFile(atOffset: fileChunkSize + 1)
+            fileHandle.closeFile()
+            return url
+        }
+
+        let config = URLSessionConfiguration.default
+        config.protocolClasses = [DropboxUploadStub.self]
+        let baseURL = "https://\(DropboxUploadStub.host)/2"
+        let transportClient = DropboxTransportClient(accessToken: "token", baseHosts: ["api": baseURL, "content": baseURL, "notify": baseURL], userAgent: nil, selectUser: nil, sessionConfiguration: config)
+        client = DropboxClient(transportClient: transportClient)
+    }
+
+    override func tearDown() {
+        try? FileManager.default.removeItem(at: directory)
+        super.tearDown()
+    }
+
+    static func threadCount() -> Int {
+        var threads: thread_act_array_t?
+        var count: mach_msg_type_number_t = 0
+        guard task_threads(mach_task_self_, &threads, &count) == KERN_SUCCESS, let list = threads else {
+            return 0
+        }
+
+        vm_deallocate(mach_task_self_, vm_address_t(UInt(bitPattern: list)), vm_size_t(Int(count) * MemoryLayout<thread_t>.stride))
+        return Int(count)
+    }
+
+    func testLargeFilesUploadWithoutParkingThreads() {
+        var commitInfo = [URL: Files.CommitInfo]()
+        for (index, file) in files.enumerated() {
+            commitInfo[file] = Files.CommitInfo(path: "/file\(index)")
+        }
+
+        // Sample the number of threads while uploading.
+        let baselineThreads = BatchUploadTests.threadCount()
+        var peakThreads = baselineThreads
+        let sampler = Timer.scheduledTimer(withTimeInterval: 0.01, repeats: true) { _ in
+            peakThreads = max(peakThreads, BatchUploadTests.threadCount())
+        }
+
+        let exp = expectation(description: "upload")
+        let start = Date()
+        var results: [URL: Files.UploadSessionFinishBatchResultEntry]?
+        var batchError: CallError<Async.PollError>?
+        var fileErrors = [URL: CallError<Async.PollError>]()
+
+        client.files.batchUploadFiles(fileUrlsToCommitInfo: commitInfo) { fileResults, error, errors in
+            results = fileResults
+            batchError = error
+            fileErrors = errors
+            exp.fulfill()
+        }
+
+        waitForExpectations(timeout: 60, handler: nil)
+        let duration = Date().timeIntervalSince(start)
+        sampler.invalidate()
+
+        XCTAssert(batchError == nil, "\(String(describing: batchError))")
+        XCTAssert(fileErrors.isEmpty, "\(fileErrors)")
+        XCTAssert(results?.count == numberOfFiles, "\(String(describing: results?.count))")
+        XCTAssert(DropboxUploadStub.sessionsStarted == numberOfFiles)
+
+        // Large files are uploaded two at a time.
+        XCTAssert(DropboxUploadStub.maxOpenSessions == maxConcurrentLargeFileUploads, "\(DropboxUploadStub.maxOpenSessions)")
+
+        // No thread waits on a chunk, so the number of threads doesn't grow with the number of files.
+        XCTAssert(peakThreads - baselineThreads < numberOfFiles, "baseline: \(baselineThreads); peak: \(peakThreads)")
+
+        let megabytes = Double(UInt64(numberOfFiles) * (fileChunkSize + 1)) / (1024 * 1024)
+        print("BatchUploadTests: \(megabytes) MB in \(duration) s: \(megabytes / duration) MB/s; threads: baseline \(baselineThreads), peak \(peakThreads)")
+
+        // Two sessions in flight with the next chunk read ahead: about one round of start and append per pair of files, plus finishing the batch (which sleeps 2 s).
+        let expectedDuration = Double(numberOfFiles) * DropboxUploadStub.latency + 2
+        XCTAssert(duration < expectedDuration * 4, "\(duration)")
+    }
+}
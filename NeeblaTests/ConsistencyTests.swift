@@ -0,0 +1,102 @@
+//
+//  ConsistencyTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+@testable import SyncServer
+import SyncServer_Shared
+
+class ConsistencyTests: XCTestCase {
+    func serverFile(_ fileUUID: String, deleted: Bool = false) -> FileInfo {
+        let file = FileInfo()
+        file.fileUUID = fileUUID
+        file.deleted = deleted
+        return file
+    }
+
+    func testConsistentFiles() {
+        let uuids = (0..<5).map { _ in UUID().uuidString }
+        let entries = Dictionary(uniqueKeysWithValues: uuids.map { ($0, false) })
+
+        let report = Consistency.compare(serverFiles: uuids.map { serverFile($0) }, localFiles: uuids, directoryEntryDeletions: entries)
+        XCTAssert(report.isConsistent, report.message)
+    }
+
+    func testEachKindOfProblemIsFound() {
+        let deletedOnServer = UUID().uuidString
+        let notLocal = UUID().uuidString
+        let notOnServer = UUID().uuidString
+
+        let serverFiles = [serverFile(deletedOnServer, deleted: true), serverFile(notLocal)]
+        let entries = [deletedOnServer: false, notLocal: false]
+
+        let report = Consistency.compare(serverFiles: serverFiles, localFiles: [deletedOnServer, notOnServer], directoryEntryDeletions: entries)
+
+        XCTAssert(!report.isConsistent)
+        XCTAssert(report.counts[.deletedServerFileInLocalFiles] == 1)
+        XCTAssert(report.counts[.localFileDeletedOnServer] == 1)
+        XCTAssert(report.counts[.serverFileDeletionInconsistent] == 1)
+        XCTAssert(report.counts[.serverFileNotInLocalFiles] == 1)
+        XCTAssert(report.counts[.localFileNotOnServer] == 1)
+        XCTAssert(report.counts[.localFileNotInDirectoryEntries] == 1)
+        XCTAssert(report.serverFilesNotPresentLocally == [notLocal])
+    }
+
+    // Counts are complete, but only the first few files of each problem are listed.
+    func testReportListsBoundedNumberOfFiles() {
+        let number = Consistency.maxFilesListedPerProblem * 3
+        let localFiles = (0..<number).map { _ in UUID().uuidString }
+        let entries = Dictionary(uniqueKeysWithValues: localFiles.map { ($0, false) })
+
+        let report = Consistency.compare(serverFiles: [], localFiles: localFiles, directoryEntryDeletions: entries)
+
+        XCTAssert(report.counts[.localFileNotOnServer] == number)
+        XCTAssert(report.files[.localFileNotOnServer]?.count == Consistency.maxFilesListedPerProblem)
+        XCTAssert(report.message.contains("\(Consistency.Problem.localFileNotOnServer.rawValue): \(number) file(s), including"), report.message)
+        XCTAssert(report.message.count < 2000, "\(report.message.count)")
+    }
+
+    func testRepairListIsNotBounded() {
+        let number = Consistency.maxFilesListedPerProblem * 3
+        let uuids = (0..<number).map { _ in UUID().uuidString }
+        let entries = Dictionary(uniqueKeysWithValues: uuids.map { ($0, false) })
+
+        let report = Consistency.compare(serverFiles: uuids.map { serverFile($0) }, localFiles: [], directoryEntryDeletions: entries)
+        XCTAssert(report.serverFilesNotPresentLocally.count == number)
+    }
+
+    // 100,000 files, with a sprinkling of each kind of problem.
+    func testCompare100kFilesPerformance() {
+        let number = 100000
+        let uuids = (0..<number).map { _ in UUID().uuidString }
+
+        var serverFiles = [FileInfo]()
+        var localFiles = [UUIDString]()
+        var entries = [UUIDString: Bool]()
+
+        for (index, uuid) in uuids.enumerated() {
+            if index % 1000 != 1 {
+                serverFiles += [serverFile(uuid, deleted: index % 1000 == 2)]
+            }
+            if index % 1000 != 3 {
+                localFiles += [uuid]
+            }
+            if index % 1000 != 4 {
+                entries[uuid] = false
+            }
+        }
+
+        var report: Consistency.Report!
+        measure {
+            report = Consistency.compare(serverFiles: serverFiles, localFiles: localFiles, directoryEntryDeletions: entries)
+        }
+
+        XCTAssert(report.counts[.localFileNotOnServer] == number / 1000)
+        XCTAssert(report.counts[.serverFileNotInLocalFiles] == number / 1000)
+        XCTAssert(report.files[.localFileNotOnServer]?.count == Consistency.maxFilesListedPerProblem)
+    }
+}
@@ -0,0 +1,94 @@
+//
+//  DiscussionMessagesTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+@testable import Neebla
+import MessageKit
+
+class DiscussionMessagesTests: XCTestCase {
+    let numberOfMessages = 2000
+    
+    // Roughly the number of times MessageKit asks for a message (data source, display and layout delegates) per cell.
+    let accessesPerCell = 8
+    
+    var fixedObjects: FixedObjects!
+    
+    override func setUp() {
+        super.setUp()
+        
+        fixedObjects = FixedObjects()
+        let sender = Sender(id: "1", displayName: "Chris")
+        let start = Date(timeIntervalSince1970: 1500000000)
+        
+        for index in 0..<numberOfMessages {
+            // A few messages per day.
+            let sentDate = start.addingTimeInterval(Double(index) * 60 * 60 * 5)
+            let message = DiscussionMessage(messageId: "\(index)", sender: sender, sentDate: sentDate, sentTimezone: "UTC", kind: .text("Message \(index)"))
+            try! fixedObjects.add(newFixedObject: message.toDictionary()!)
+        }
+    }
+    
+    func testMessagesMatchFixedObjects() {
+        guard let messages = DiscussionMessages(fixedObjects: fixedObjects) else {
+            XCTFail()
+            return
+        }
+        
+        XCTAssert(messages.count == numberOfMessages)
+        XCTAssert(messages.isFirstOfDay(at: 0))
+        
+        for index in 1..<numberOfMessages {
+            let previous = DiscussionMessage.fromDictionary(fixedObjects[index - 1] as! [String: String])!
+            let current = DiscussionMessage.fromDictionary(fixedObjects[index] as! [String: String])!
+            XCTAssert(messages[index].messageId == current.messageId)
+            XCTAssert(messages.isFirstOfDay(at: index) == !Calendar.current.isDate(current.sentDate, inSameDayAs: previous.sentDate))
+        }
+    }
+    
+    func testInvalidFixedObjectFails() {
+        try! fixedObjects.add(newFixedObject: [FixedObjects.idKey: "bad"])
+        XCTAssert(DiscussionMessages(fixedObjects: fixedObjects) == nil)
+    }
+    
+    func testAppendTracksDays() {
+        var messages = DiscussionMessages()
+        let sender = Sender(id: "1", displayName: "Chris")
+        let date = Date()
+        messages.append(DiscussionMessage(messageId: "1", sender: sender, sentDate: date, sentTimezone: "UTC", kind: .text("a")))
+        messages.append(DiscussionMessage(messageId: "2", sender: sender, sentDate: date, sentTimezone: "UTC", kind: .text("b")))
+        messages.append(DiscussionMessage(messageId: "3", sender: sender, sentDate: date.addingTimeInterval(3 * 24 * 60 * 60), sentTimezone: "UTC", kind: .text("c")))
+        
+        XCTAssert(messages.isFirstOfDay(at: 0))
+        XCTAssert(!messages.isFirstOfDay(at: 1))
+        XCTAssert(messages.isFirstOfDay(at: 2))
+    }
+    
+    // Scrolling through the whole discussion, as MessageKit would, with the decoded messages.
+    func testScrollPerformance() {
+        let messages = DiscussionMessages(fixedObjects: fixedObjects)!
+        measure {
+            for index in 0..<numberOfMessages {
+                for _ in 0..<accessesPerCell {
+                    _ = messages[index].sentDate
+                }
+                _ = messages.isFirstOfDay(at: index)
+            }
+        }
+    }
+    
+    // The same scroll, parsing each message from its fixed object on every access-- as was done before.
+    func testScrollPerformanceParsingPerAccess() {
+        measure {
+            for index in 0..<numberOfMessages {
+                for _ in 0..<accessesPerCell {
+                    _ = DiscussionMessage.fromDictionary(fixedObjects[index] as! [String: String])!.sentDate
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+//
+//  LOTAnimationCacheTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import Lottie
+
+class LOTAnimationCacheTests: XCTestCase {
+    let lookups = 100000
+    
+    private func makeCache(count: Int) -> (LOTAnimationCache, [String]) {
+        let cache = LOTAnimationCache()
+        cache.totalCostLimit = UInt(count)
+        
+        let animation = LOTComposition(json: [:])
+        let keys = (0..<count).map { "animation\($0)" }
+        keys.forEach { cache.addAnimation(animation, forKey: $0, cost: 1) }
+        return (cache, keys)
+    }
+    
+    func testLeastRecentlyUsedIsEvictedByCost() {
+        let cache = LOTAnimationCache()
+        cache.totalCostLimit = 100
+        
+        cache.addAnimation(LOTComposition(json: [:]), forKey: "a", cost: 40)
+        cache.addAnimation(LOTComposition(json: [:]), forKey: "b", cost: 40)
+        
+        // Makes "b" the least recently used.
+        XCTAssert(cache.animation(forKey: "a") != nil)
+        
+        cache.addAnimation(LOTComposition(json: [:]), forKey: "c", cost: 40)
+        
+        XCTAssert(cache.animation(forKey: "a") != nil)
+        XCTAssert(cache.animation(forKey: "b") == nil)
+        XCTAssert(cache.animation(forKey: "c") != nil)
+        XCTAssert(cache.totalCost == 80, "\(cache.totalCost)")
+        XCTAssert(cache.count == 2)
+    }
+    
+    func testReplacingAndRemovingAdjustCost() {
+        let cache = LOTAnimationCache()
+        cache.addAnimation(LOTComposition(json: [:]), forKey: "a", cost: 10)
+        cache.addAnimation(LOTComposition(json: [:]), forKey: "a", cost: 30)
+        XCTAssert(cache.totalCost == 30)
+        XCTAssert(cache.count == 1)
+        
+        cache.removeAnimation(forKey: "a")
+        XCTAssert(cache.totalCost == 0)
+        XCTAssert(cache.animation(forKey: "a") == nil)
+    }
+    
+    func testAnimationLargerThanLimitIsNotCached() {
+        let cache = LOTAnimationCache()
+        cache.totalCostLimit = 100
+        cache.addAnimation(LOTComposition(json: [:]), forKey: "small", cost: 10)
+        cache.addAnimation(LOTComposition(json: [:]), forKey: "large", cost: 101)
+        
+        XCTAssert(cache.animation(forKey: "large") == nil)
+        XCTAssert(cache.animation(forKey: "small") != nil)
+    }
+    
+    func testLoweringLimitEvicts() {
+        let (cache, keys) = makeCache(count: 10)
+        cache.totalCostLimit = 5
+        
+        XCTAssert(cache.count == 5)
+        XCTAssert(cache.animation(forKey: keys[0]) == nil)
+        XCTAssert(cache.animation(forKey: keys[9]) != nil)
+    }
+    
+    // Hit path latency: the time for `lookups` hits should stay flat as the cache grows.
+    private func measureHits(count: Int) {
+        let (cache, keys) = makeCache(count: count)
+        measure {
+            for index in 0..<lookups {
+                _ = cache.animation(forKey: keys[index % count])
+            }
+        }
+    }
+    
+    func testHitLatency10() {
+        measureHits(count: 10)
+    }
+    
+    func testHitLatency100() {
+        measureHits(count: 100)
+    }
+    
+    func testHitLatency1000() {
+        measureHits(count: 1000)
+    }
+    
+    func testHitLatency10000() {
+        measureHits(count: 10000)
+    }
+}
@@ -0,0 +1,180 @@
+//
+//  LOTTrimPathTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import Lottie
+
+// Path trimming is internal to Lottie; these drive it through an animation view with a stroked, trimmed wave of many curve segments.
+class LOTTrimPathTests: XCTestCase {
+    let numberOfSegments = 1000
+    let numberOfFrames = 300
+    let tangentLength = 0.7
+    
+    private func vertex(_ index: Int, amplitude: Double) -> CGPoint {
+        let y = index % 2 == 0 ? amplitude : -amplitude
+        return CGPoint(x: Double(index) * 2, y: 100 + y)
+    }
+    
+    private func makeAnimationView(animatedShape: Bool) -> LOTAnimationView {
+        func wave(amplitude: Double) -> [String: Any] {
+            let vertices = (0...numberOfSegments).map { index -> [Double] in
+                let point = vertex(index, amplitude: amplitude)
+                return [Double(point.x), Double(point.y)]
+            }
+            let inTangents = vertices.map { _ in [-tangentLength, 0] }
+            let outTangents = vertices.map { _ in [tangentLength, 0] }
+            return ["v": vertices, "i": inTangents, "o": outTangents, "c": false]
+        }
+        
+        let shape: [String: Any] = animatedShape ?
+            ["k": [
+                ["t": 0, "s": [wave(amplitude: 10)], "e": [wave(amplitude: 50)], "i": ["x": 0.5, "y": 0.5], "o": ["x": 0.5, "y": 0.5]],
+                ["t": numberOfFrames]
+            ]] :
+            ["k": wave(amplitude: 10)]
+        
+        let trimEnd: [String: Any] = ["k": [
+            ["t": 0, "s": [0], "e": [100], "i": ["x": [0.5], "y": [0.5]], "o": ["x": [0.5], "y": [0.5]]],
+            ["t": numberOfFrames]
+        ]]
+        
+        let layer: [String: Any] = [
+            "ty": 4, "ind": 1, "nm": "wave",
+            "ip": 0, "op": numberOfFrames, "st": 0,
+            "ks": [
+                "o": ["k": 100],
+                "p": ["k": [0, 0]],
+                "a": ["k": [0, 0]],
+                "s": ["k": [100, 100]],
+                "r": ["k": 0]
+            ],
+            "shapes": [
+                ["ty": "sh", "nm": "path", "ks": shape],
+                ["ty": "st", "nm": "stroke", "c": ["k": [1, 0, 0, 1]], "o": ["k": 100], "w": ["k": 2], "lc": 2, "lj": 2],
+                ["ty": "tm", "nm": "trim", "s": ["k": 0], "e": trimEnd, "o": ["k": 0]]
+            ]
+        ]
+        
+        let json: [String: Any] = [
+            "v": "5.1.0", "fr": 30, "ip": 0, "op": numberOfFrames,
+            "w": numberOfSegments * 2, "h": 200,
+            "layers": [layer]
+        ]
+        
+        return LOTAnimationView(model: LOTComposition(json: json), in: nil)
+    }
+    
+    private func strokeLayer(in layer: CALayer) -> CAShapeLayer? {
+        if let shapeLayer = layer as? CAShapeLayer, shapeLayer.strokeColor != nil {
+            return shapeLayer
+        }
+        
+        for sublayer in layer.sublayers ?? [] {
+            if let shapeLayer = strokeLayer(in: sublayer) {
+                return shapeLayer
+            }
+        }
+        
+        return nil
+    }
+    
+    // Where the trimmed stroke should end: `fraction` of the way along the wave, by arc length. The segments are all the same length, so that's a whole number of segments, and then a fraction of the next, measured here by finely flattening it.
+    private func expectedEnd(fraction: Double, amplitude: Double) -> CGPoint {
+        let position = fraction * Double(numberOfSegments)
+        let segment = min(Int(position), numberOfSegments - 1)
+        let segmentFraction = position - Double(segment)
+        
+        let p0 = vertex(segment, amplitude: amplitude)
+        let p3 = vertex(segment + 1, amplitude: amplitude)
+        let p1 = CGPoint(x: Double(p0.x) + tangentLength, y: Double(p0.y))
+        let p2 = CGPoint(x: Double(p3.x) - tangentLength, y: Double(p3.y))
+        
+        func point(_ t: Double) -> CGPoint {
+            let u = 1 - t
+            let a = u * u * u, b = 3 * u * u * t, c = 3 * u * t * t, d = t * t * t
+            return CGPoint(x: a * Double(p0.x) + b * Double(p1.x) + c * Double(p2.x) + d * Double(p3.x),
+                y: a * Double(p0.y) + b * Double(p1.y) + c * Double(p2.y) + d * Double(p3.y))
+        }
+        
+        let steps = 10000
+        var lengths = [0.0]
+        var previous = point(0)
+        for step in 1...steps {
+            let current = point(Double(step) / Double(steps))
+            lengths += [lengths.last! + Double(hypot(current.x - previous.x, current.y - previous.y))]
+            previous = current
+        }
+        
+        let target = segmentFraction * lengths.last!
+        let step = lengths.firstIndex { $0 >= target } ?? steps
+        return point(Double(step) / Double(steps))
+    }
+    
+    // The trim end goes linearly from 0% to 100% over the animation, and the animated shape's amplitude from 10 to 50.
+    private func checkTrimmedEnd(animatedShape: Bool) {
+        let view = makeAnimationView(animatedShape: animatedShape)
+        for frame in [45, 100, 150.5, 299] as [Double] {
+            view.setProgressWithFrame(NSNumber(value: frame))
+            view.layer.sublayers?.forEach { $0.displayIfNeeded() }
+            
+            guard let path = strokeLayer(in: view.layer)?.path else {
+                XCTFail()
+                return
+            }
+            
+            let fraction = frame / Double(numberOfFrames)
+            let amplitude = animatedShape ? 10 + 40 * fraction : 10
+            let expected = expectedEnd(fraction: fraction, amplitude: amplitude)
+            
+            // The stroke starts at the start of the wave, and ends part way along it.
+            let bounds = path.boundingBoxOfPath
+            XCTAssertEqual(bounds.minX, 0, accuracy: 0.01)
+            XCTAssertEqual(bounds.maxX, expected.x, accuracy: 0.25, "frame: \(frame)")
+            
+            let end = path.currentPoint
+            XCTAssert(hypot(end.x - expected.x, end.y - expected.y) < 1, "frame: \(frame); end: \(end); expected: \(expected)")
+        }
+    }
+    
+    func testTrimmedEndStaticShape() {
+        checkTrimmedEnd(animatedShape: false)
+    }
+    
+    func testTrimmedEndAnimatedShape() {
+        checkTrimmedEnd(animatedShape: true)
+    }
+    
+    private func measurePlayback(animatedShape: Bool) {
+        let view = makeAnimationView(animatedShape: animatedShape)
+        measure {
+            for frame in 0..<numberOfFrames {
+                view.animationProgress = CGFloat(frame) / CGFloat(numberOfFrames)
+            }
+        }
+    }
+    
+    // Per frame cost when only the trim changes; the shape's arc lengths can be reused.
+    func testTrimPlaybackStaticShape() {
+        measurePlayback(animatedShape: false)
+    }
+    
+    // Per frame cost when the shape changes too, so its arc lengths are measured each frame.
+    func testTrimPlaybackAnimatedShape() {
+        measurePlayback(animatedShape: true)
+    }
+    
+    func testTrimScrubbing() {
+        let view = makeAnimationView(animatedShape: false)
+        let progresses = (0..<numberOfFrames).map { _ in CGFloat.random(in: 0...1) }
+        measure {
+            for progress in progresses {
+                view.animationProgress = progress
+            }
+        }
+    }
+}
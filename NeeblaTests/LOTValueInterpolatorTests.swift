@@ -0,0 +1,137 @@
+//
+//  LOTValueInterpolatorTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import Lottie
+
+// Keyframe lookup is internal to Lottie; these drive it through an animation view with a single layer whose opacity has many keyframes.
+class LOTValueInterpolatorTests: XCTestCase {
+    let numberOfKeyframes = 5000
+    let numberOfFrames = 2000
+    
+    // Frames before the first keyframe and after the last, so seeks can go past either end of the keyframes.
+    let keyframeOffset = 10
+    
+    var totalFrames: Int {
+        return numberOfKeyframes + 2 * keyframeOffset
+    }
+    
+    // Opacity, in percent, at each keyframe.
+    private func value(atKeyframe index: Int) -> Int {
+        return (index + 50) % 100
+    }
+    
+    private func makeAnimationView() -> LOTAnimationView {
+        let keyframes: [[String: Any]] = (0..<numberOfKeyframes).map { index in
+            return [
+                "t": keyframeOffset + index,
+                "s": [value(atKeyframe: index)],
+                "e": [value(atKeyframe: index + 1)],
+                "i": ["x": [0.5], "y": [0.5]],
+                "o": ["x": [0.5], "y": [0.5]]
+            ]
+        }
+        
+        let layer: [String: Any] = [
+            "ty": 1, "ind": 1, "nm": "solid",
+            "ip": 0, "op": totalFrames, "st": 0,
+            "sw": 100, "sh": 100, "sc": "#ff0000",
+            "ks": [
+                "o": ["k": keyframes],
+                "p": ["k": [50, 50]],
+                "a": ["k": [0, 0]],
+                "s": ["k": [100, 100]],
+                "r": ["k": 0]
+            ]
+        ]
+        
+        let json: [String: Any] = [
+            "v": "5.1.0", "fr": 30, "ip": 0, "op": totalFrames,
+            "w": 100, "h": 100,
+            "layers": [layer]
+        ]
+        
+        return LOTAnimationView(model: LOTComposition(json: json), in: nil)
+    }
+    
+    private func solidLayer(in layer: CALayer) -> CALayer? {
+        if layer.value(forKey: "layerName") as? String == "solid" {
+            return layer
+        }
+        
+        for sublayer in layer.sublayers ?? [] {
+            if let solid = solidLayer(in: sublayer) {
+                return solid
+            }
+        }
+        
+        return nil
+    }
+    
+    // The keyframes ease linearly (their tangents are on the diagonal). Before the first keyframe, and after the last, the value is held.
+    private func expectedOpacity(atFrame frame: CGFloat) -> CGFloat {
+        let time = frame - CGFloat(keyframeOffset)
+        let last = numberOfKeyframes - 1
+        if time <= 0 {
+            return CGFloat(value(atKeyframe: 0)) / 100
+        }
+        if time >= CGFloat(last) {
+            return CGFloat(value(atKeyframe: last)) / 100
+        }
+        
+        let index = Int(time.rounded(.down))
+        let start = CGFloat(value(atKeyframe: index))
+        let end = CGFloat(value(atKeyframe: index + 1))
+        return (start + (end - start) * (time - CGFloat(index))) / 100
+    }
+    
+    // Playback: each frame is in the same or the next keyframe span.
+    func testSequentialPlayback() {
+        let view = makeAnimationView()
+        measure {
+            for frame in 0..<numberOfFrames {
+                view.animationProgress = CGFloat(frame) / CGFloat(numberOfFrames)
+            }
+        }
+    }
+    
+    // Scrubbing: every frame is a seek to somewhere else in the animation.
+    func testRandomSeeks() {
+        let view = makeAnimationView()
+        let progresses = (0..<numberOfFrames).map { _ in CGFloat.random(in: 0...1) }
+        measure {
+            for progress in progresses {
+                view.animationProgress = progress
+            }
+        }
+    }
+    
+    // Forward, back and past either end of the keyframes, without crashing or getting stuck: the opacity is right at each seek.
+    func testSeeksBothWays() {
+        let view = makeAnimationView()
+        guard let solid = solidLayer(in: view.layer), let compContainer = solid.superlayer?.superlayer else {
+            XCTFail()
+            return
+        }
+        
+        let first = CGFloat(keyframeOffset)
+        let last = CGFloat(keyframeOffset + numberOfKeyframes - 1)
+        
+        // Exactly on keyframes (including one easing from 99% down to 0%, and the first and last), between them, and before and after all of them.
+        let frames: [CGFloat] = [2500.5, first + 549, first + 550, 500.25, first + 4500, 0, CGFloat(totalFrames), first, last, 1250.75, first + 49.5, 5, last + 5, first + 2500]
+        
+        for frame in frames {
+            view.setProgressWithFrame(NSNumber(value: Double(frame)))
+            compContainer.displayIfNeeded()
+            
+            XCTAssertEqual(view.animationProgress, frame / CGFloat(totalFrames), accuracy: 0.001)
+            XCTAssertFalse(solid.isHidden)
+            XCTAssertEqual(CGFloat(solid.opacity), expectedOpacity(atFrame: frame), accuracy: 0.001, "frame: \(frame)")
+        }
+    }
+}
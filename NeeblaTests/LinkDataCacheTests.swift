@@ -0,0 +1,89 @@
+//
+//  LinkDataCacheTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import SMLinkPreview
+
+class LinkDataCacheTests: XCTestCase {
+    var directory: URL!
+    var cache: LinkDataCache!
+    var fetches = 0
+    
+    override func setUp() {
+        super.setUp()
+        directory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        cache = LinkDataCache(directory: directory)
+        fetches = 0
+    }
+    
+    override func tearDown() {
+        try? FileManager.default.removeItem(at: directory)
+        super.tearDown()
+    }
+    
+    func getLinkData(url: URL, title: String? = "title") -> LinkData? {
+        let exp = expectation(description: "linkData")
+        var result: LinkData?
+        
+        cache.linkData(for: url, accept: nil, fetch: { completion in
+            self.fetches += 1
+            completion(title.map { LinkData(url: url, title: $0, description: nil, image: nil, icon: nil) })
+        }, completion: { linkData in
+            result = linkData
+            exp.fulfill()
+        })
+        
+        waitForExpectations(timeout: 10, handler: nil)
+        return result
+    }
+    
+    func testFreshEntryDoesNotFetchAgain() {
+        let url = URL(string: "https://cprince.com/some/page")!
+        XCTAssert(getLinkData(url: url)?.title == "title")
+        XCTAssert(getLinkData(url: url)?.title == "title")
+        XCTAssert(fetches == 1)
+    }
+    
+    func testNormalizedURLsShareAnEntry() {
+        XCTAssert(getLinkData(url: URL(string: "https://cprince.com/page?b=2&a=1")!) != nil)
+        XCTAssert(getLinkData(url: URL(string: "http://www.CPrince.com/page/?a=1&b=2#top")!) != nil)
+        XCTAssert(fetches == 1)
+    }
+    
+    func testCacheHitHasRequestedURL() {
+        let first = URL(string: "https://cprince.com/page?b=2&a=1")!
+        let second = URL(string: "http://www.CPrince.com/page/?a=1&b=2#top")!
+        XCTAssert(getLinkData(url: first)?.url == first)
+        XCTAssert(getLinkData(url: second)?.url == second)
+        XCTAssert(fetches == 1)
+    }
+    
+    func testEntryPersistsAcrossInstances() {
+        let url = URL(string: "https://cprince.com")!
+        XCTAssert(getLinkData(url: url) != nil)
+        
+        cache = LinkDataCache(directory: directory)
+        XCTAssert(getLinkData(url: url) != nil)
+        XCTAssert(fetches == 1)
+    }
+    
+    func testFailedFetchIsNotCached() {
+        let url = URL(string: "https://cprince.com/missing")!
+        XCTAssert(getLinkData(url: url, title: nil) == nil)
+        XCTAssert(getLinkData(url: url) != nil)
+        XCTAssert(fetches == 2)
+    }
+    
+    func testRemoveAll() {
+        let url = URL(string: "https://cprince.com")!
+        XCTAssert(getLinkData(url: url) != nil)
+        cache.removeAll()
+        XCTAssert(getLinkData(url: url) != nil)
+        XCTAssert(fetches == 2)
+    }
+}
@@ -0,0 +1,71 @@
+//
+//  LinkImageLoaderTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import SMLinkPreview
+
+class LinkImageLoaderTests: XCTestCase {
+    var imageURL: URL!
+
+    override func setUp() {
+        super.setUp()
+        LinkImageLoader.session.removeAll()
+
+        let format = UIGraphicsImageRendererFormat()
+        format.scale = 1
+        let image = UIGraphicsImageRenderer(size: CGSize(width: 1000, height: 500), format: format).image { context in
+            UIColor.blue.setFill()
+            context.fill(CGRect(x: 0, y: 0, width: 1000, height: 500))
+        }
+
+        imageURL = FileManager.default.temporaryDirectory.appendingPathComponent("LinkImageLoaderTests.png")
+        try? image.pngData()?.write(to: imageURL)
+    }
+
+    override func tearDown() {
+        try? FileManager.default.removeItem(at: imageURL)
+        super.tearDown()
+    }
+
+    func testImageIsDownsampledAndCached() {
+        let exp = expectation(description: "load")
+        LinkImageLoader.session.loadImage(for: imageURL, maxPixelSize: 100) { image in
+            XCTAssert(Thread.isMainThread)
+            XCTAssert(image?.cgImage?.width == 100, "\(String(describing: image?.cgImage?.width))")
+            XCTAssert(image?.cgImage?.height == 50)
+            exp.fulfill()
+        }
+        waitForExpectations(timeout: 10, handler: nil)
+
+        XCTAssert(LinkImageLoader.session.cachedImage(for: imageURL, maxPixelSize: 100) != nil)
+        XCTAssert(LinkImageLoader.session.cachedImage(for: imageURL, maxPixelSize: 200) == nil)
+    }
+
+    func testCancelledRequestDoesNotCallBack() {
+        let request = LinkImageLoader.session.loadImage(for: imageURL, maxPixelSize: 100) { _ in
+            XCTFail()
+        }
+        request.cancel()
+
+        let exp = expectation(description: "wait")
+        DispatchQueue.main.asyncAfter(deadline: .now() + 1) {
+            exp.fulfill()
+        }
+        waitForExpectations(timeout: 10, handler: nil)
+    }
+
+    func testMissingImageGivesNil() {
+        let exp = expectation(description: "load")
+        let missing = FileManager.default.temporaryDirectory.appendingPathComponent("LinkImageLoaderTests.missing.png")
+        LinkImageLoader.session.loadImage(for: missing, maxPixelSize: 100) { image in
+            XCTAssert(image == nil)
+            exp.fulfill()
+        }
+        waitForExpectations(timeout: 10, handler: nil)
+    }
+}
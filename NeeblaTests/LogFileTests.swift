@@ -0,0 +1,64 @@
+//
+//  LogFileTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import SMCoreLib
+
+class LogFileTests: XCTestCase {
+    let numberOfLines = 10000
+    let line = "2019-10-19 10:00:00.000 [Debug] [ServerAPI.swift:123] downloadFile(fileToDownload:): Some sync state in a log line\n"
+    
+    private var appLogPath: String!
+    private let testLogURL = FileManager.default.temporaryDirectory.appendingPathComponent("LogFileTests.txt")
+    
+    // Don't write test lines into the app's own log.
+    override func setUp() {
+        super.setUp()
+        appLogPath = LogFile.path()
+        try? FileManager.default.removeItem(at: testLogURL)
+        LogFile.setPath(testLogURL.path)
+    }
+    
+    override func tearDown() {
+        LogFile.setPath(appLogPath)
+        try? FileManager.default.removeItem(at: testLogURL)
+        super.tearDown()
+    }
+    
+    // Caller latency: the time spent in `write` only; the file writes happen in the background.
+    func testWriteCallerLatency() {
+        measure {
+            for _ in 0..<numberOfLines {
+                LogFile.write(line)
+            }
+        }
+    }
+    
+    // Throughput: lines/sec, including getting all of them to disk.
+    func testWriteAndFlushThroughput() {
+        measure {
+            for _ in 0..<numberOfLines {
+                LogFile.write(line)
+            }
+            LogFile.flush()
+        }
+    }
+    
+    func testFlushWritesBufferedLines() {
+        let marker = "LogFileTests-\(UUID().uuidString)\n"
+        LogFile.write(marker)
+        LogFile.flush()
+        
+        guard let contents = try? String(contentsOf: testLogURL) else {
+            XCTFail()
+            return
+        }
+        
+        XCTAssert(contents.contains(marker))
+    }
+}
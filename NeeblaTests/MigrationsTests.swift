@@ -0,0 +1,98 @@
+//
+//  MigrationsTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+@testable import Neebla
+import SMCoreLib
+
+class MigrationsTests: XCTestCase {
+    static let done = SMPersistItemBool(name: "MigrationsTests.done", initialBoolValue: false, persistType: .userDefaults)
+    static let checkpoint = SMPersistItemString(name: "MigrationsTests.checkpoint", initialStringValue: "", persistType: .userDefaults)
+
+    let numberOfObjects = 25
+    let batchSize = 10
+    var sharingGroupUUID: String!
+    var objects = [DiscussionFileObject]()
+
+    // The uuids of the objects migrated, in order; "nil" for the object without one.
+    var migrated = [String]()
+
+    override func setUp() {
+        super.setUp()
+        MigrationsTests.done.reset()
+        MigrationsTests.checkpoint.reset()
+
+        sharingGroupUUID = UUID().uuidString
+        migrated = []
+
+        objects = (0...numberOfObjects).map { index in
+            let object = DiscussionFileObject.newObjectAndMakeUUID(makeUUID: index < numberOfObjects) as! DiscussionFileObject
+            object.sharingGroupUUID = sharingGroupUUID
+            return object
+        }
+        CoreData.sessionNamed(CoreDataExtras.sessionName).saveContext()
+    }
+
+    override func tearDown() {
+        for object in objects {
+            CoreData.sessionNamed(CoreDataExtras.sessionName).remove(object)
+        }
+        CoreData.sessionNamed(CoreDataExtras.sessionName).saveContext()
+
+        MigrationsTests.done.reset()
+        MigrationsTests.checkpoint.reset()
+        super.tearDown()
+    }
+
+    var migration: Migrations.Migration {
+        let step = Migrations.Step(entityName: DiscussionFileObject.entityName(), predicate: NSPredicate(format: "sharingGroupUUID == %@", sharingGroupUUID), migrate: { objects in
+            self.migrated += objects.map { $0.uuid ?? "nil" }
+        })
+
+        return Migrations.Migration(name: "MigrationsTests", done: MigrationsTests.done, checkpoint: MigrationsTests.checkpoint, steps: [step])
+    }
+
+    func testMigrationReachesEveryObject() {
+        XCTAssert(Migrations(batchSize: batchSize).run(migrations: [migration]))
+        XCTAssert(MigrationsTests.done.boolValue)
+        XCTAssert(MigrationsTests.checkpoint.stringValue == "")
+
+        let expected = Set(objects.map { $0.uuid ?? "nil" })
+        XCTAssert(migrated.count == expected.count, "\(migrated.count)")
+        XCTAssert(Set(migrated) == expected)
+    }
+
+    func testDoneMigrationIsNotRunAgain() {
+        XCTAssert(Migrations(batchSize: batchSize).run(migrations: [migration]))
+        migrated = []
+
+        XCTAssert(Migrations(batchSize: batchSize).run(migrations: [migration]))
+        XCTAssert(migrated.isEmpty)
+    }
+
+    // Stop after one batch, as if the app were killed, and then run again, as on the next launch.
+    func testInterruptedMigrationResumes() {
+        XCTAssert(!Migrations(batchSize: batchSize).run(migrations: [migration], maxBatches: 1))
+        XCTAssert(!MigrationsTests.done.boolValue)
+        XCTAssert(MigrationsTests.checkpoint.stringValue != "")
+
+        // The object without a uuid, and the first batch.
+        let firstRun = migrated
+        XCTAssert(firstRun.count == batchSize + 1, "\(firstRun.count)")
+        XCTAssert(firstRun.first == "nil")
+
+        migrated = []
+        XCTAssert(Migrations(batchSize: batchSize).run(migrations: [migration]))
+        XCTAssert(MigrationsTests.done.boolValue)
+
+        // The second run picks up after the first batch, rather than starting over.
+        XCTAssert(migrated.count == numberOfObjects - batchSize, "\(migrated.count)")
+        XCTAssert(Set(firstRun).isDisjoint(with: migrated))
+        XCTAssert(Set(firstRun + migrated) == Set(objects.map { $0.uuid ?? "nil" }))
+    }
+}
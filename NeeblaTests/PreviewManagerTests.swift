@@ -0,0 +1,172 @@
+//
+//  PreviewManagerTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import SMLinkPreview
+
+// A local LinkSource answering after a configurable latency.
+class StubLinkSource: LinkSource {
+    static var requestKeyName: String?
+    
+    let latency: TimeInterval
+    let title: String?
+    private(set) var started = false
+    private var cancelledRequests = Set<UUID>()
+    private let lock = NSLock()
+    
+    var cancelled: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return !cancelledRequests.isEmpty
+    }
+    
+    // A nil title means the source fails.
+    init(latency: TimeInterval, title: String?) {
+        self.latency = latency
+        self.title = title
+    }
+    
+    required init?(apiKey: APIKey?) {
+        return nil
+    }
+    
+    func getLinkData(url: URL, requestId: UUID, completion: @escaping (LinkData?) -> ()) {
+        started = true
+        DispatchQueue.global().asyncAfter(deadline: .now() + latency) {
+            self.lock.lock()
+            let cancelled = self.cancelledRequests.contains(requestId)
+            self.lock.unlock()
+            
+            guard let title = self.title, !cancelled else {
+                completion(nil)
+                return
+            }
+            completion(LinkData(url: url, title: title, description: nil, image: nil, icon: nil))
+        }
+    }
+    
+    func cancelLinkData(requestId: UUID) {
+        lock.lock()
+        cancelledRequests.insert(requestId)
+        lock.unlock()
+    }
+}
+
+class PreviewManagerTests: XCTestCase {
+    let url = URL(string: "https://cprince.com")!
+    var savedConfig: PreviewConfiguration!
+    var savedFilter: ((LinkData)->(Bool))?
+    
+    override func setUp() {
+        super.setUp()
+        savedConfig = PreviewManager.session.config
+        savedFilter = PreviewManager.session.linkDataFilter
+        PreviewManager.session.linkDataFilter = nil
+    }
+    
+    override func tearDown() {
+        PreviewManager.session.config = savedConfig
+        PreviewManager.session.linkDataFilter = savedFilter
+        super.tearDown()
+    }
+    
+    func getTitle(strategy: ProviderStrategy, sources: [StubLinkSource]) -> (title: String?, duration: TimeInterval) {
+        PreviewManager.session.config = PreviewConfiguration(providerStrategy: strategy)
+        
+        let exp = expectation(description: "linkData")
+        let start = Date()
+        var title: String?
+        var duration: TimeInterval = 0
+        
+        PreviewManager.session.getLinkData(url: url, from: sources) { linkData in
+            XCTAssert(Thread.isMainThread)
+            title = linkData?.title
+            duration = Date().timeIntervalSince(start)
+            exp.fulfill()
+        }
+        
+        waitForExpectations(timeout: 10, handler: nil)
+        return (title, duration)
+    }
+    
+    func testSequentialWaitsForSlowFirstSource() {
+        let sources = [StubLinkSource(latency: 1, title: "slow"), StubLinkSource(latency: 0, title: "fast")]
+        let result = getTitle(strategy: .sequential, sources: sources)
+        XCTAssert(result.title == "slow")
+        XCTAssert(!sources[1].started)
+    }
+    
+    func testSequentialFailsOver() {
+        let sources = [StubLinkSource(latency: 0, title: nil), StubLinkSource(latency: 0, title: "second")]
+        let result = getTitle(strategy: .sequential, sources: sources)
+        XCTAssert(result.title == "second")
+    }
+    
+    func testHedgedStartsNextSourceAfterDelay() {
+        let sources = [StubLinkSource(latency: 3, title: "slow"), StubLinkSource(latency: 0.1, title: "fast")]
+        let result = getTitle(strategy: .hedged(delay: 0.2), sources: sources)
+        XCTAssert(result.title == "fast")
+        XCTAssert(result.duration < 2)
+        XCTAssert(sources[0].cancelled)
+    }
+    
+    func testHedgedDoesNotStartNextSourceWhenFirstIsFast() {
+        let sources = [StubLinkSource(latency: 0, title: "first"), StubLinkSource(latency: 0, title: "second")]
+        let result = getTitle(strategy: .hedged(delay: 1), sources: sources)
+        XCTAssert(result.title == "first")
+        XCTAssert(!sources[1].started)
+    }
+    
+    func testRaceTakesFirstPassingFilter() {
+        PreviewManager.session.linkDataFilter = { linkData in
+            return linkData.title != "fastest"
+        }
+        
+        let sources = [StubLinkSource(latency: 2, title: "slow"), StubLinkSource(latency: 0, title: "fastest"), StubLinkSource(latency: 0.2, title: "next")]
+        let result = getTitle(strategy: .race, sources: sources)
+        XCTAssert(result.title == "next")
+        XCTAssert(sources[0].cancelled)
+    }
+    
+    // The race below cancels the shared source's part in it; that mustn't cancel the other request for the same url.
+    func testCancellingDoesNotAffectConcurrentRequestForSameURL() {
+        let shared = StubLinkSource(latency: 1, title: "shared")
+        
+        PreviewManager.session.config = PreviewConfiguration(providerStrategy: .race)
+        let raceExp = expectation(description: "race")
+        var raceTitle: String?
+        PreviewManager.session.getLinkData(url: url, from: [shared, StubLinkSource(latency: 0, title: "fast")]) { linkData in
+            raceTitle = linkData?.title
+            raceExp.fulfill()
+        }
+        
+        let sequentialExp = expectation(description: "sequential")
+        var sequentialTitle: String?
+        PreviewManager.session.getLinkData(url: url, from: [shared]) { linkData in
+            sequentialTitle = linkData?.title
+            sequentialExp.fulfill()
+        }
+        
+        waitForExpectations(timeout: 10, handler: nil)
+        
+        XCTAssert(raceTitle == "fast")
+        XCTAssert(shared.cancelled)
+        XCTAssert(sequentialTitle == "shared")
+    }
+    
+    func testAllSourcesFailing() {
+        let sources = [StubLinkSource(latency: 0.1, title: nil), StubLinkSource(latency: 0, title: nil)]
+        let result = getTitle(strategy: .race, sources: sources)
+        XCTAssert(result.title == nil)
+    }
+    
+    func testNoSources() {
+        let result = getTitle(strategy: .hedged(delay: 0.1), sources: [])
+        XCTAssert(result.title == nil)
+    }
+}
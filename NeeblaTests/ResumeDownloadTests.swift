@@ -0,0 +1,164 @@
+//
+//  ResumeDownloadTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+@testable import SyncServer
+import SyncServer_Shared
+
+// Serves `contents`, honoring Range requests. With `failAfter` set, a full download drops the connection after that many bytes.
+class RangeServerStub: URLProtocol {
+    static let host = "range.stub"
+    static let eTag = "\"resume-test\""
+    static var contents = Data()
+    static var failAfter: Int?
+    private(set) static var ranges = [String?]()
+
+    static func reset() {
+        contents = Data()
+        failAfter = nil
+        ranges = []
+    }
+
+    override class func canInit(with request: URLRequest) -> Bool {
+        return request.url?.host == host
+    }
+
+    override class func canonicalRequest(for request: URLRequest) -> URLRequest {
+        return request
+    }
+
+    override func startLoading() {
+        let contents = RangeServerStub.contents
+        let range = request.value(forHTTPHeaderField: "Range")
+        RangeServerStub.ranges += [range]
+
+        var headers = ["Accept-Ranges": "bytes", "ETag": RangeServerStub.eTag, "Last-Modified": "Sat, 19 Oct 2019 00:00:00 GMT"]
+
+        // Only "bytes=<start>-", which is what URLSession sends when resuming.
+        if let range = range, let start = Int(range.replacingOccurrences(of: "bytes=", with: "").replacingOccurrences(of: "-", with: "")) {
+            headers["Content-Range"] = "bytes \(start)-\(contents.count - 1)/\(contents.count)"
+            headers["Content-Length"] = "\(contents.count - start)"
+            let response = HTTPURLResponse(url: request.url!, statusCode: HTTPStatus.partialContent.rawValue, httpVersion: "HTTP/1.1", headerFields: headers)!
+            client?.urlProtocol(self, didReceive: response, cacheStoragePolicy: .notAllowed)
+            client?.urlProtocol(self, didLoad: contents.subdata(in: start..<contents.count))
+            client?.urlProtocolDidFinishLoading(self)
+            return
+        }
+
+        headers["Content-Length"] = "\(contents.count)"
+        let response = HTTPURLResponse(url: request.url!, statusCode: HTTPStatus.ok.rawValue, httpVersion: "HTTP/1.1", headerFields: headers)!
+        client?.urlProtocol(self, didReceive: response, cacheStoragePolicy: .notAllowed)
+
+        if let failAfter = RangeServerStub.failAfter {
+            client?.urlProtocol(self, didLoad: contents.subdata(in: 0..<failAfter))
+            client?.urlProtocol(self, didFailWithError: URLError(.networkConnectionLost))
+        }
+        else {
+            client?.urlProtocol(self, didLoad: contents)
+            client?.urlProtocolDidFinishLoading(self)
+        }
+    }
+
+    override func stopLoading() {
+    }
+}
+
+class ResumeDownloadTests: XCTestCase {
+    let file = ServerNetworkingLoadingFile(fileUUID: UUID().uuidString, fileVersion: 0)
+    var directory: URL!
+    var resumeData: DownloadResumeData!
+    var session: URLSession!
+
+    override func setUp() {
+        super.setUp()
+        RangeServerStub.reset()
+        RangeServerStub.contents = Data((0..<100000).map { UInt8($0 % 251) })
+
+        directory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        resumeData = DownloadResumeData(directory: directory)
+
+        let config = URLSessionConfiguration.default
+        config.protocolClasses = [RangeServerStub.self]
+        session = URLSession(configuration: config)
+    }
+
+    override func tearDown() {
+        session.invalidateAndCancel()
+        try? FileManager.default.removeItem(at: directory)
+        super.tearDown()
+    }
+
+    func download(with task: (@escaping (URL?, URLResponse?, Error?) -> ()) -> URLSessionDownloadTask) -> (Data?, HTTPURLResponse?, Error?) {
+        var result: (Data?, HTTPURLResponse?, Error?) = (nil, nil, nil)
+        let exp = expectation(description: "download")
+        task { location, response, error in
+            result = (location.flatMap { try? Data(contentsOf: $0) }, response as? HTTPURLResponse, error)
+            exp.fulfill()
+        }.resume()
+
+        waitForExpectations(timeout: 10, handler: nil)
+        return result
+    }
+
+    func testInterruptedDownloadResumesWithRangeRequest() {
+        let url = URL(string: "https://\(RangeServerStub.host)/downloadFile")!
+        let half = RangeServerStub.contents.count / 2
+        RangeServerStub.failAfter = half
+
+        let (_, _, error) = download { session.downloadTask(with: url, completionHandler: $0) }
+        guard let data = (error as NSError?)?.userInfo[NSURLSessionDownloadTaskResumeData] as? Data else {
+            XCTFail("No resume data: \(String(describing: error))")
+            return
+        }
+
+        resumeData.save(data, for: file)
+        RangeServerStub.failAfter = nil
+
+        guard let saved = resumeData.take(for: file) else {
+            XCTFail()
+            return
+        }
+
+        // Resume data is used only once.
+        XCTAssert(resumeData.take(for: file) == nil)
+
+        let (contents, response, resumeError) = download { session.downloadTask(withResumeData: saved, completionHandler: $0) }
+        XCTAssert(resumeError == nil, "\(String(describing: resumeError))")
+
+        // The second request asked for just the rest of the file, and the result is the whole file.
+        XCTAssert(RangeServerStub.ranges.last == "bytes=\(half)-", "\(RangeServerStub.ranges)")
+        XCTAssert(contents == RangeServerStub.contents)
+
+        XCTAssert(response?.statusCode == HTTPStatus.partialContent.rawValue)
+        let downloadResponse = ServerNetworkingLoading.downloadResponse(response, resumed: true)
+        XCTAssert(downloadResponse?.statusCode == HTTPStatus.ok.rawValue)
+        XCTAssert(downloadResponse?.allHeaderFields["ETag"] as? String == RangeServerStub.eTag)
+    }
+
+    // A 206 is only success for a download we resumed.
+    func testPartialContentIsNotSuccessUnlessResumed() {
+        let url = URL(string: "https://\(RangeServerStub.host)/downloadFile")!
+        let response = HTTPURLResponse(url: url, statusCode: HTTPStatus.partialContent.rawValue, httpVersion: nil, headerFields: nil)
+        XCTAssert(ServerNetworkingLoading.downloadResponse(response, resumed: false)?.statusCode == HTTPStatus.partialContent.rawValue)
+
+        let unauthorized = HTTPURLResponse(url: url, statusCode: HTTPStatus.unauthorized.rawValue, httpVersion: nil, headerFields: nil)
+        XCTAssert(ServerNetworkingLoading.downloadResponse(unauthorized, resumed: true)?.statusCode == HTTPStatus.unauthorized.rawValue)
+    }
+
+    // Its auth headers would have expired by now.
+    func testOldResumeDataIsNotUsed() {
+        resumeData.save(Data("resume".utf8), for: file)
+
+        let fileURL = directory.appendingPathComponent("\(file.fileUUID).\(file.fileVersion)")
+        let old = Date(timeIntervalSinceNow: -DownloadResumeData.maximumAge - 60)
+        try! FileManager.default.setAttributes([.modificationDate: old], ofItemAtPath: fileURL.path)
+
+        XCTAssert(resumeData.take(for: file) == nil)
+        XCTAssert(!FileManager.default.fileExists(atPath: fileURL.path))
+    }
+}
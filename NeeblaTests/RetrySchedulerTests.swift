@@ -0,0 +1,306 @@
+//
+//  RetrySchedulerTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+@testable import SyncServer
+import SyncServer_Shared
+
+// Stands in for the server: the next `failures` requests get `failureStatusCode` (with `retryAfter`, if set), and the rest get a 200. Every response has an empty JSON body.
+class RetryServerStub: URLProtocol {
+    static let host = "retry.stub"
+
+    private static let lock = NSLock()
+    private static var _failures = 0
+    private static var _failureStatusCode = 500
+    private static var _retryAfter: String?
+    private static var _requests = [(path: String, date: Date)]()
+
+    static var requests: [(path: String, date: Date)] {
+        lock.lock()
+        defer { lock.unlock() }
+        return _requests
+    }
+
+    static func fail(next failures: Int, statusCode: Int = 500, retryAfter: String? = nil) {
+        lock.lock()
+        _failures = failures
+        _failureStatusCode = statusCode
+        _retryAfter = retryAfter
+        lock.unlock()
+    }
+
+    static func reset() {
+        fail(next: 0)
+        lock.lock()
+        _requests = []
+        lock.unlock()
+    }
+
+    override class func canInit(with request: URLRequest) -> Bool {
+        return request.url?.host == host
+    }
+
+    override class func canonicalRequest(for request: URLRequest) -> URLRequest {
+        return request
+    }
+
+    override func startLoading() {
+        var statusCode = HTTPStatus.ok.rawValue
+        var headers = ["Content-Type": "application/json"]
+
+        RetryServerStub.lock.lock()
+        RetryServerStub._requests += [(path: request.url!.path, date: Date())]
+        if RetryServerStub._failures > 0 {
+            RetryServerStub._failures -= 1
+            statusCode = RetryServerStub._failureStatusCode
+            headers["Retry-After"] = RetryServerStub._retryAfter
+        }
+        RetryServerStub.lock.unlock()
+
+        let response = HTTPURLResponse(url: request.url!, statusCode: statusCode, httpVersion: "HTTP/1.1", headerFields: headers)!
+        client?.urlProtocol(self, didReceive: response, cacheStoragePolicy: .notAllowed)
+        client?.urlProtocol(self, didLoad: Data("{}".utf8))
+        client?.urlProtocolDidFinishLoading(self)
+    }
+
+    override func stopLoading() {
+    }
+}
+
+class RetrySchedulerTests: XCTestCase {
+    // Simulated seconds; the clock of `scheduler`.
+    var time: TimeInterval = 0
+    var seed: UInt64 = 1
+    var scheduler: RetryScheduler!
+
+    // For requests through ServerAPI, which use `RetryScheduler.session` and real time.
+    var originalScheduler: RetryScheduler!
+    var originalConfiguration: URLSessionConfiguration!
+    var realScheduler: RetryScheduler!
+
+    override func setUp() {
+        super.setUp()
+        time = 0
+        seed = 1
+        scheduler = RetryScheduler(now: { [unowned self] in
+            return Date(timeIntervalSinceReferenceDate: self.time)
+        }, random: { [unowned self] range in
+            return range.lowerBound + (range.upperBound - range.lowerBound) * self.nextRandom()
+        })
+
+        RetryServerStub.reset()
+        originalScheduler = RetryScheduler.session
+        originalConfiguration = ServerNetworking.session.sessionConfiguration
+
+        // Short delays, so the retries happen within the test.
+        realScheduler = RetryScheduler(baseDelay: 0.01, maximumDelay: 0.05, openDuration: 2)
+        RetryScheduler.session = realScheduler
+
+        let configuration = URLSessionConfiguration.default
+        configuration.protocolClasses = [RetryServerStub.self]
+        ServerNetworking.session.sessionConfiguration = configuration
+    }
+
+    override func tearDown() {
+        RetryScheduler.session = originalScheduler
+        ServerNetworking.session.sessionConfiguration = originalConfiguration
+        super.tearDown()
+    }
+
+    // A seeded generator, so the tests are the same every run.
+    func nextRandom() -> Double {
+        seed = seed &* 6364136223846793005 &+ 1442695040888963407
+        return Double(seed >> 11) / Double(UInt64(1) << 53)
+    }
+
+    // Sends requests, with retries, through ServerAPI to the stub, and waits for all of them to complete.
+    func send(_ paths: [String]) -> [(statusCode: Int?, error: SyncServerError?)] {
+        var results = [(statusCode: Int?, error: SyncServerError?)]()
+        let lock = NSLock()
+        let exp = expectation(description: "send")
+        exp.expectedFulfillmentCount = paths.count
+
+        for path in paths {
+            let url = URL(string: "https://\(RetryServerStub.host)\(path)")!
+            ServerAPI.session.sendRequestUsing(method: .get, toURL: url) { _, statusCode, error in
+                lock.lock()
+                results += [(statusCode: statusCode, error: error)]
+                lock.unlock()
+                exp.fulfill()
+            }
+        }
+
+        waitForExpectations(timeout: 20, handler: nil)
+        return results
+    }
+
+    func requests(to path: String) -> [Date] {
+        return RetryServerStub.requests.filter { $0.path == path }.map { $0.date }
+    }
+
+    // JSON endpoints, and not just uploads and downloads, wait as long as the server asks.
+    func testRetryAfterIsHonoredForJSONEndpoints() {
+        RetryServerStub.fail(next: 1, statusCode: 429, retryAfter: "1")
+
+        let results = send(["/index"])
+        XCTAssert(results.count == 1 && results[0].error == nil && results[0].statusCode == HTTPStatus.ok.rawValue, "\(results)")
+
+        // Without the Retry-After, the retry would have come after at most `maximumDelay`.
+        let dates = requests(to: "/index")
+        guard dates.count == 2 else {
+            XCTFail("\(dates)")
+            return
+        }
+
+        let delay = dates[1].timeIntervalSince(dates[0])
+        XCTAssert(delay >= 0.9, "\(delay)")
+    }
+
+    // The server fails every request for a while, and then recovers.
+    func testOutageIsContainedAndRecovers() {
+        let endpoints = ["/uploadFile", "/downloadFile", "/index"]
+        let paths = (0..<12).map { endpoints[$0 % endpoints.count] }
+        RetryServerStub.fail(next: Int.max)
+
+        // Without the breaker, each request would be tried `maximumNumberRetries` (3) times. With it, only failures before it opens get retried.
+        let results = send(paths)
+        XCTAssert(results.count == paths.count && results.allSatisfy { $0.error != nil }, "\(results)")
+
+        let attempts = RetryServerStub.requests.count
+        XCTAssert(attempts >= paths.count && attempts < paths.count + realScheduler.failureThreshold, "\(attempts)")
+
+        guard case .open = realScheduler.circuitState else {
+            XCTFail("\(realScheduler.circuitState)")
+            return
+        }
+
+        // While it's open, first attempts still go to the server, but aren't retried.
+        XCTAssert(send(["/index"]).allSatisfy { $0.error != nil })
+        XCTAssert(RetryServerStub.requests.count == attempts + 1)
+
+        // The server comes back. After `openDuration`, the failed first attempt gets a trial retry, which succeeds and closes the breaker.
+        Thread.sleep(forTimeInterval: realScheduler.openDuration)
+        RetryServerStub.fail(next: 1)
+
+        let trial = send(["/index"])
+        XCTAssert(trial.count == 1 && trial[0].error == nil, "\(trial)")
+        XCTAssert(RetryServerStub.requests.count == attempts + 3)
+
+        guard case .closed = realScheduler.circuitState else {
+            XCTFail("\(realScheduler.circuitState)")
+            return
+        }
+
+        XCTAssert(send(endpoints).allSatisfy { $0.error == nil && $0.statusCode == HTTPStatus.ok.rawValue })
+        XCTAssert(RetryServerStub.requests.count == attempts + 3 + endpoints.count)
+    }
+
+    // Requests that failed together don't retry together.
+    func testDelaysAreJittered() {
+        let delays = (0..<20).compactMap { scheduler.retryDelay(endpoint: "/endpoint\($0)", previousDelay: nil) }
+        XCTAssert(delays.count == 20)
+        XCTAssert(delays.allSatisfy { $0 >= scheduler.baseDelay && $0 <= scheduler.maximumDelay })
+        XCTAssert(Set(delays).count == delays.count)
+
+        var previousDelay: TimeInterval?
+        for _ in 0..<10 {
+            let delay = scheduler.retryDelay(endpoint: "/index", previousDelay: previousDelay)!
+            XCTAssert(delay >= scheduler.baseDelay && delay <= max(scheduler.baseDelay, (previousDelay ?? scheduler.baseDelay) * 3))
+            previousDelay = delay
+        }
+    }
+
+    func openBreaker() {
+        for _ in 0..<scheduler.failureThreshold {
+            scheduler.record(statusCode: 500, succeeded: false)
+        }
+
+        guard case .open = scheduler.circuitState else {
+            XCTFail("\(scheduler.circuitState)")
+            return
+        }
+
+        XCTAssert(scheduler.retryDelay(endpoint: "/index", previousDelay: nil) == nil)
+
+        // Let the trial retry through.
+        time += scheduler.openDuration
+        XCTAssert(scheduler.retryDelay(endpoint: "/index", previousDelay: nil) != nil)
+        guard case .halfOpen = scheduler.circuitState else {
+            XCTFail("\(scheduler.circuitState)")
+            return
+        }
+
+        XCTAssert(scheduler.retryDelay(endpoint: "/index", previousDelay: nil) == nil)
+    }
+
+    // The server answered, so it's up; the breaker mustn't be left half open.
+    func testUnauthorizedTrialClosesBreaker() {
+        openBreaker()
+        scheduler.record(statusCode: HTTPStatus.unauthorized.rawValue, succeeded: false)
+
+        guard case .closed = scheduler.circuitState else {
+            XCTFail("\(scheduler.circuitState)")
+            return
+        }
+
+        XCTAssert(scheduler.retryDelay(endpoint: "/index", previousDelay: nil) != nil)
+    }
+
+    func testFailedTrialReopensBreaker() {
+        openBreaker()
+        scheduler.record(statusCode: 500, succeeded: false)
+
+        guard case .open = scheduler.circuitState else {
+            XCTFail("\(scheduler.circuitState)")
+            return
+        }
+
+        XCTAssert(scheduler.retryDelay(endpoint: "/index", previousDelay: nil) == nil)
+    }
+
+    func testSuccessfulTrialClosesBreaker() {
+        openBreaker()
+        scheduler.record(statusCode: HTTPStatus.ok.rawValue, succeeded: true)
+
+        guard case .closed = scheduler.circuitState else {
+            XCTFail("\(scheduler.circuitState)")
+            return
+        }
+    }
+
+    func testRetryBudgetRefills() {
+        for _ in 0..<Int(scheduler.budgetCapacity) {
+            XCTAssert(scheduler.retryDelay(endpoint: "/uploadFile", previousDelay: nil) != nil)
+        }
+
+        XCTAssert(scheduler.retryDelay(endpoint: "/uploadFile", previousDelay: nil) == nil)
+
+        // Other endpoints have their own budget.
+        XCTAssert(scheduler.retryDelay(endpoint: "/index", previousDelay: nil) != nil)
+
+        time += 1 / scheduler.budgetRefillRate
+        XCTAssert(scheduler.retryDelay(endpoint: "/uploadFile", previousDelay: nil) != nil)
+        XCTAssert(scheduler.retryDelay(endpoint: "/uploadFile", previousDelay: nil) == nil)
+    }
+
+    func testRetryAfterHoldsOffEndpoint() {
+        let retryAfter: TimeInterval = 20
+        let delay = scheduler.retryDelay(endpoint: "/uploadFile", previousDelay: nil, retryAfter: retryAfter)
+        XCTAssert(delay != nil && delay! >= retryAfter)
+
+        // Other requests to the same endpoint wait too; those to other endpoints don't.
+        time += 5
+        let otherDelay = scheduler.retryDelay(endpoint: "/uploadFile", previousDelay: nil)
+        XCTAssert(otherDelay != nil && otherDelay! >= retryAfter - 5)
+
+        let otherEndpointDelay = scheduler.retryDelay(endpoint: "/index", previousDelay: nil)
+        XCTAssert(otherEndpointDelay != nil && otherEndpointDelay! < retryAfter - 5)
+
+        XCTAssert(scheduler.retryDelay(endpoint: "/index", previousDelay: nil, retryAfter: scheduler.maximumRetryAfter + 1) == nil)
+    }
+}
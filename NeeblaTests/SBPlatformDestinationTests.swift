@@ -0,0 +1,206 @@
+//
+//  SBPlatformDestinationTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+@testable import SwiftyBeaver
+
+// Stands in for the SwiftyBeaver platform: answers each post with `statusCode`, and keeps the encrypted payloads.
+class SBPlatformServerStub: URLProtocol {
+    static let host = "sbplatform.stub"
+    static var statusCode = 200
+
+    private static let lock = NSLock()
+    private static var _payloads = [String]()
+
+    static var payloads: [String] {
+        lock.lock()
+        defer { lock.unlock() }
+        return _payloads
+    }
+
+    static func reset() {
+        lock.lock()
+        statusCode = 200
+        _payloads = []
+        lock.unlock()
+    }
+
+    override class func canInit(with request: URLRequest) -> Bool {
+        return request.url?.host == host
+    }
+
+    override class func canonicalRequest(for request: URLRequest) -> URLRequest {
+        return request
+    }
+
+    // URLProtocol gets the body of a request as a stream.
+    private func body() -> Data {
+        if let body = request.httpBody {
+            return body
+        }
+
+        guard let stream = request.httpBodyStream else {
+            return Data()
+        }
+
+        var data = Data()
+        var buffer = [UInt8](repeating: 0, count: 64 * 1024)
+        stream.open()
+        while stream.hasBytesAvailable {
+            let count = stream.read(&buffer, maxLength: buffer.count)
+            if count <= 0 {
+                break
+            }
+            data.append(buffer, count: count)
+        }
+        stream.close()
+        return data
+    }
+
+    override func startLoading() {
+        SBPlatformServerStub.lock.lock()
+        let statusCode = SBPlatformServerStub.statusCode
+        if let json = try? JSONSerialization.jsonObject(with: body()) as? [String: String],
+            let payload = json["payload"] {
+            SBPlatformServerStub._payloads += [payload]
+        }
+        SBPlatformServerStub.lock.unlock()
+
+        let response = HTTPURLResponse(url: request.url!, statusCode: statusCode, httpVersion: "HTTP/1.1", headerFields: nil)!
+        client?.urlProtocol(self, didReceive: response, cacheStoragePolicy: .notAllowed)
+        client?.urlProtocol(self, didLoad: Data())
+        client?.urlProtocolDidFinishLoading(self)
+    }
+
+    override func stopLoading() {
+    }
+}
+
+class SBPlatformDestinationTests: XCTestCase {
+    let encryptionKey = "01234567890123456789012345678901"
+    var prefix: String!
+    var destination: SBPlatformDestination!
+
+    override func setUp() {
+        super.setUp()
+        SBPlatformServerStub.reset()
+
+        prefix = UUID().uuidString
+        destination = SBPlatformDestination(appID: "app", appSecret: "secret", encryptionKey: encryptionKey, serverURL: URL(string: "https://\(SBPlatformServerStub.host)/api/entries/"), entriesFileName: prefix + ".json", sendingfileName: prefix + ".sending.json", analyticsFileName: prefix + ".analytics.json")
+
+        let configuration = URLSessionConfiguration.default
+        configuration.protocolClasses = [SBPlatformServerStub.self]
+        destination.sessionConfiguration = configuration
+    }
+
+    override func tearDown() {
+        for url in [destination.entriesFileURL, destination.sendingFileURL, destination.sendingOffsetFileURL, destination.analyticsFileURL] {
+            try? FileManager.default.removeItem(at: url)
+        }
+        super.tearDown()
+    }
+
+    // As SwiftyBeaver does: on the destination's queue.
+    func log(_ level: SwiftyBeaver.Level, _ message: String) {
+        destination.queue!.sync {
+            _ = destination.send(level, msg: message, thread: "", file: #file, function: #function, line: #line)
+        }
+    }
+
+    // Sends the sending file, and then whatever was logged since, waiting for each to be accepted.
+    func sendEverything(timeout: TimeInterval) {
+        let fileManager = FileManager.default
+        let deadline = Date().addingTimeInterval(timeout)
+
+        while fileManager.fileExists(atPath: destination.sendingFileURL.path) ||
+            fileManager.fileExists(atPath: destination.entriesFileURL.path) {
+            destination.queue!.sync {
+                destination.sendNow()
+            }
+
+            let sent = expectation(for: NSPredicate { _, _ in
+                return !fileManager.fileExists(atPath: self.destination.sendingFileURL.path)
+            }, evaluatedWith: nil, handler: nil)
+            wait(for: [sent], timeout: max(deadline.timeIntervalSinceNow, 1))
+
+            if Date() > deadline {
+                XCTFail("Not sent")
+                return
+            }
+        }
+    }
+
+    func entries(inPayloads payloads: [String]) -> [[String: Any]] {
+        return payloads.flatMap { payload -> [[String: Any]] in
+            guard let decrypted = AES256CBC.decryptString(payload, password: encryptionKey),
+                let json = try? JSONSerialization.jsonObject(with: Data(decrypted.utf8)) as? [String: Any],
+                let entries = json["entries"] as? [[String: Any]] else {
+                XCTFail()
+                return []
+            }
+            return entries
+        }
+    }
+
+    // While the server is failing (e.g., offline), each log line mustn't post the first batch again.
+    func testFailedSendsBackOff() {
+        SBPlatformServerStub.statusCode = 500
+        destination.sendingInterval = 0.2
+
+        // Verbose lines have no points, so only the interval sends them.
+        let start = Date()
+        var lines = 0
+        while Date().timeIntervalSince(start) < 2 {
+            log(.verbose, "line \(lines)")
+            lines += 1
+            Thread.sleep(forTimeInterval: 0.01)
+        }
+
+        // Attempts about 0.2, 0.4, 0.8 and 1.6 s apart.
+        let attempts = SBPlatformServerStub.payloads.count
+        XCTAssert(attempts >= 2 && attempts <= 5, "lines: \(lines); attempts: \(attempts)")
+
+        // Errors have enough points to cross the threshold, but wait too.
+        for index in 0..<20 {
+            log(.error, "error \(index)")
+        }
+        XCTAssert(SBPlatformServerStub.payloads.count <= attempts + 1, "\(SBPlatformServerStub.payloads.count)")
+
+        // Once the server is back, every line gets there.
+        SBPlatformServerStub.statusCode = 200
+        sendEverything(timeout: 10)
+
+        let received = Set(entries(inPayloads: SBPlatformServerStub.payloads).compactMap { $0["message"] as? String })
+        XCTAssert(received.count == lines + 20, "\(received.count)")
+    }
+
+    // 40,000 lines, about 10 MB, of backlog: read, encrypted and posted in batches.
+    func testSendThroughput() {
+        let numberOfLines = 40000
+        let message = String(repeating: "x", count: 200)
+
+        var text = ""
+        for index in 0..<numberOfLines {
+            let dict: [String: Any] = ["timestamp": Date().timeIntervalSince1970, "level": 2, "message": "\(index) \(message)", "thread": "", "fileName": "SBPlatformDestinationTests.swift", "function": "testSendThroughput()", "line": index]
+            text += String(data: try! JSONSerialization.data(withJSONObject: dict), encoding: .utf8)! + "\n"
+        }
+        try! text.write(to: destination.entriesFileURL, atomically: true, encoding: .utf8)
+        let bytes = Double(text.utf8.count)
+
+        let start = Date()
+        sendEverything(timeout: 600)
+        let duration = Date().timeIntervalSince(start)
+
+        let payloads = SBPlatformServerStub.payloads
+        XCTAssert(payloads.count >= Int(bytes) / destination.maxBatchBytes, "\(payloads.count)")
+        XCTAssert(entries(inPayloads: payloads).count == numberOfLines)
+
+        let megabytes = bytes / (1024 * 1024)
+        print("SBPlatformDestinationTests: \(megabytes) MB, \(numberOfLines) lines, in \(payloads.count) posts, in \(duration) s: \(megabytes / duration) MB/s; \(Double(numberOfLines) / duration) lines/s")
+    }
+}
@@ -0,0 +1,113 @@
+//
+//  SMPersistVarsTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+import SMCoreLib
+
+class SMPersistVarsTests: XCTestCase {
+    static let intItem = SMPersistItemInt(name: "SMPersistVarsTests.int", initialIntValue: 0, persistType: .userDefaults)
+    static let stringItem = SMPersistItemString(name: "SMPersistVarsTests.string", initialStringValue: "", persistType: .userDefaults)
+    static let arrayItem = SMPersistItemArray(name: "SMPersistVarsTests.array", initialArrayValue: NSMutableArray(), persistType: .userDefaults)
+    static let keyChainItem = SMPersistItemString(name: "SMPersistVarsTests.keyChain", initialStringValue: "", persistType: .keyChain)
+    
+    override func tearDown() {
+        SMPersistVarsTests.intItem.reset()
+        SMPersistVarsTests.stringItem.reset()
+        SMPersistVarsTests.arrayItem.reset()
+        SMPersistVarsTests.keyChainItem.reset()
+        super.tearDown()
+    }
+    
+    func testSetIsReadBackBeforeFlush() {
+        SMPersistVarsTests.intItem.intValue = 42
+        XCTAssert(SMPersistVarsTests.intItem.intValue == 42)
+    }
+    
+    func testFlushWritesToUserDefaults() {
+        let value = UUID().uuidString
+        SMPersistVarsTests.stringItem.stringValue = value
+        SMPersistVars.session().flush(synchronously: true)
+        
+        guard let data = UserDefaults.standard.data(forKey: SMPersistVarsTests.stringItem.name),
+            let stored = NSKeyedUnarchiver.unarchiveObject(with: data) as? String else {
+            XCTFail()
+            return
+        }
+        
+        XCTAssert(stored == value)
+    }
+    
+    func testLastOfCoalescedSetsIsWritten() {
+        for count in 1...100 {
+            SMPersistVarsTests.intItem.intValue = count
+        }
+        SMPersistVars.session().flush(synchronously: true)
+        
+        guard let data = UserDefaults.standard.data(forKey: SMPersistVarsTests.intItem.name),
+            let stored = NSKeyedUnarchiver.unarchiveObject(with: data) as? Int else {
+            XCTFail()
+            return
+        }
+        
+        XCTAssert(stored == 100)
+    }
+    
+    // The value written is the one given to the set, not whatever the (mutable) value has become by the time of the flush.
+    func testWriteIsSnapshotAtSet() {
+        let array = NSMutableArray(array: [1])
+        SMPersistVarsTests.arrayItem.arrayValue = array
+        array.add(2)
+        SMPersistVars.session().flush(synchronously: true)
+        
+        guard let data = UserDefaults.standard.data(forKey: SMPersistVarsTests.arrayItem.name),
+            let stored = NSKeyedUnarchiver.unarchiveObject(with: data) as? [Int] else {
+            XCTFail()
+            return
+        }
+        
+        XCTAssert(stored == [1])
+    }
+    
+    // KeyChain sets are written through; a fresh item with the same name reads the value without any flush.
+    func testKeyChainSetIsWrittenThrough() {
+        let value = UUID().uuidString
+        SMPersistVarsTests.keyChainItem.stringValue = value
+        
+        let other = SMPersistItemString(name: SMPersistVarsTests.keyChainItem.name, initialStringValue: "", persistType: .keyChain)
+        XCTAssert(other.stringValue == value)
+    }
+    
+    func testResetDropsPendingWrite() {
+        SMPersistVarsTests.intItem.intValue = 7
+        SMPersistVarsTests.intItem.reset()
+        SMPersistVars.session().flush(synchronously: true)
+
+        XCTAssert(UserDefaults.standard.object(forKey: SMPersistVarsTests.intItem.name) == nil)
+        XCTAssert(SMPersistVarsTests.intItem.intValue == 0)
+    }
+    
+    // Reads, as during collection view layout.
+    func testReadPerformance() {
+        SMPersistVarsTests.intItem.intValue = 1
+        measure {
+            var sum = 0
+            for _ in 0..<100000 {
+                sum += SMPersistVarsTests.intItem.intValue
+            }
+            XCTAssert(sum == 100000)
+        }
+    }
+    
+    func testSetPerformance() {
+        measure {
+            for count in 0..<1000 {
+                SMPersistVarsTests.intItem.intValue = count
+            }
+        }
+    }
+}
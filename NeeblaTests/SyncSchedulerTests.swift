@@ -0,0 +1,101 @@
+//
+//  SyncSchedulerTests.swift
+//  NeeblaTests
+//
+//  Created by Christopher G Prince on 10/19/19.
+//  Copyright © 2019 Spastic Muffin, LLC. All rights reserved.
+//
+
+import XCTest
+@testable import Neebla
+
+class SyncSchedulerTests: XCTestCase {
+    func testIntervalBacksOffWhenNothingChanges() {
+        var interval: TimeInterval = 60
+        var intervals = [TimeInterval]()
+        for _ in 1...6 {
+            interval = SyncScheduler.nextInterval(after: interval, foundChanges: false, minimum: 60, maximum: 30 * 60, factor: 2)
+            intervals += [interval]
+        }
+
+        XCTAssert(intervals == [120, 240, 480, 960, 1800, 1800], "\(intervals)")
+    }
+
+    func testIntervalResetsWhenSomethingChanges() {
+        let interval = SyncScheduler.nextInterval(after: 960, foundChanges: true, minimum: 60, maximum: 30 * 60, factor: 2)
+        XCTAssert(interval == 60)
+    }
+
+    func testJitterStaysInBounds() {
+        XCTAssert(SyncScheduler.jittered(100, jitter: 0.2, random: 0) == 80)
+        XCTAssert(SyncScheduler.jittered(100, jitter: 0.2, random: 0.5) == 100)
+
+        for _ in 1...100 {
+            let interval = SyncScheduler.jittered(100, jitter: 0.2)
+            XCTAssert(interval >= 80 && interval < 120, "\(interval)")
+        }
+    }
+
+    func testCompletedSyncsAreCounted() {
+        let scheduler = SyncScheduler(startSync: { return false })
+        scheduler.syncCompleted(foundChanges: false)
+        scheduler.syncCompleted(foundChanges: true)
+        scheduler.syncCompleted(foundChanges: false)
+
+        XCTAssert(scheduler.metrics.syncsPerformed == 3)
+        XCTAssert(scheduler.metrics.syncsWithChanges == 1)
+
+        // Syncs the scheduler didn't start don't back it off.
+        XCTAssert(scheduler.currentInterval == scheduler.minimumInterval)
+    }
+
+    func testPushNotificationsCoalesceIntoOneSync() {
+        var syncs = 0
+        let scheduler = SyncScheduler(startSync: {
+            syncs += 1
+            return true
+        })
+
+        scheduler.start()
+        scheduler.syncSoon(trigger: .pushNotification)
+        scheduler.syncSoon(trigger: .pushNotification)
+        scheduler.syncSoon(trigger: .pushNotification)
+
+        let exp = expectation(description: "sync")
+        DispatchQueue.main.asyncAfter(deadline: .now() + scheduler.coalescingDelay * 1.5) {
+            exp.fulfill()
+        }
+        waitForExpectations(timeout: 10, handler: nil)
+        scheduler.stop()
+
+        XCTAssert(syncs == 1, "\(syncs)")
+        XCTAssert(scheduler.metrics.syncsByTrigger[SyncScheduler.Trigger.pushNotification.rawValue] == 1)
+    }
+
+    func testFailedSyncSchedulesAnotherWithBackoff() {
+        var syncs = 0
+        var scheduler: SyncScheduler!
+        let exp = expectation(description: "sync")
+        scheduler = SyncScheduler(minimumInterval: 0.2, maximumInterval: 10, startSync: {
+            syncs += 1
+            if syncs == 1 {
+                // Errors are reported after the sync has started.
+                DispatchQueue.main.async {
+                    scheduler.syncFailed()
+                    XCTAssert(scheduler.currentInterval == 0.4, "\(scheduler.currentInterval)")
+                }
+            }
+            else {
+                exp.fulfill()
+            }
+            return true
+        })
+
+        scheduler.start()
+        waitForExpectations(timeout: 10, handler: nil)
+        scheduler.stop()
+
+        XCTAssert(syncs == 2, "\(syncs)")
+        XCTAssert(scheduler.metrics.syncsPerformed == 0)
+    }
+}
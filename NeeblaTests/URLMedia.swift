@@ -75,4 +75,28 @@ class URLMedia: XCTestCase {
         XCTAssert(parsedContents.url == contents.url)
         XCTAssert(parsedContents.imageType == contents.imageType)
     }
+    
+    func testCachedURLFileContentsFollowFileChanges() {
+        let contents = URLMediaObject.URLFileContents(url: URL(string: "http://cprince.com")!, title: "Some title", imageType: .icon)
+        guard let url = URLMediaObject.createLocalURLFile(contents: contents) else {
+            XCTFail()
+            return
+        }
+        
+        let first = URLMediaObject.urlFileContents(localURLFile: url as URL)
+        let second = URLMediaObject.urlFileContents(localURLFile: url as URL)
+        XCTAssert(first?.title == contents.title)
+        XCTAssert(second?.url == contents.url)
+        XCTAssert(second?.imageType == contents.imageType)
+        
+        // Rewrite the file, with a later modification date.
+        let newContents = "[InternetShortcut]\nURL=http://example.com\nTITLE=Other title\n"
+        try? newContents.data(using: .utf8)?.write(to: url as URL)
+        try? FileManager.default.setAttributes([.modificationDate: Date(timeIntervalSinceNow: 60)], ofItemAtPath: (url as URL).path)
+        
+        let third = URLMediaObject.urlFileContents(localURLFile: url as URL)
+        XCTAssert(third?.title == "Other title")
+        XCTAssert(third?.url == URL(string: "http://example.com"))
+        XCTAssert(third?.imageType == nil)
+    }
 }
@@ -33,6 +33,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (instancetype)mainThreadExecutor;
 
+/*!
+ Returns an executor that runs continuations on a pool of worker threads, one per active processor, each with
+ its own deque of blocks. A continuation scheduled from a worker goes on that worker's deque and runs next on
+ the same thread (good locality for chained continuations); idle workers steal from the other end of busy
+ workers' deques. Blocks never run nested inside one another, so deep continuation chains use bounded stack.
+ */
++ (instancetype)workStealingExecutor;
+
 /*!
  Returns a new executor that uses the given block to execute continuations.
  @param block The block to use.
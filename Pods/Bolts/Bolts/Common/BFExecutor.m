@@ -10,7 +10,9 @@
 
 #import "BFExecutor.h"
 
+#import <os/lock.h>
 #import <pthread.h>
+#import <stdatomic.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -37,6 +39,160 @@ __attribute__((noinline)) static size_t remaining_stack_size(size_t *restrict to
     return (*totalSize) - (size_t)(endStack - frameAddr);
 }
 
+@class BFWorkStealingPool;
+
+/*!
+ A worker thread and its deque. The owner pushes and pops at the end of the deque (newest first); thieves take
+ from the front (oldest first), so they take the work least likely to be in the owner's cache.
+ */
+@interface BFWorkStealingWorker : NSObject {
+@public
+    __unsafe_unretained BFWorkStealingPool *_pool;
+    NSUInteger _index;
+    os_unfair_lock _lock;
+    NSMutableArray<dispatch_block_t> *_deque;
+}
+@end
+
+@implementation BFWorkStealingWorker
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) return self;
+
+    _lock = OS_UNFAIR_LOCK_INIT;
+    _deque = [NSMutableArray array];
+
+    return self;
+}
+
+- (void)push:(dispatch_block_t)block {
+    os_unfair_lock_lock(&_lock);
+    [_deque addObject:block];
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (nullable dispatch_block_t)pop {
+    os_unfair_lock_lock(&_lock);
+    dispatch_block_t block = _deque.lastObject;
+    if (block) {
+        [_deque removeLastObject];
+    }
+    os_unfair_lock_unlock(&_lock);
+    return block;
+}
+
+- (nullable dispatch_block_t)steal {
+    os_unfair_lock_lock(&_lock);
+    dispatch_block_t block = _deque.firstObject;
+    if (block) {
+        [_deque removeObjectAtIndex:0];
+    }
+    os_unfair_lock_unlock(&_lock);
+    return block;
+}
+
+@end
+
+// The worker running on the current thread, if any.
+static _Thread_local void *BFCurrentWorker = NULL;
+
+/*!
+ The worker threads behind `+[BFExecutor workStealingExecutor]`. The pool lives for the life of the process.
+ */
+@interface BFWorkStealingPool : NSObject {
+    NSArray<BFWorkStealingWorker *> *_workers;
+    _Atomic(NSUInteger) _nextWorker;
+    _Atomic(NSUInteger) _idleWorkers;
+    dispatch_semaphore_t _workAvailable;
+}
+@end
+
+@implementation BFWorkStealingPool
+
+- (instancetype)initWithWorkerCount:(NSUInteger)count {
+    self = [super init];
+    if (!self) return self;
+
+    _workAvailable = dispatch_semaphore_create(0);
+
+    NSMutableArray *workers = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger index = 0; index < count; index++) {
+        BFWorkStealingWorker *worker = [[BFWorkStealingWorker alloc] init];
+        worker->_pool = self;
+        worker->_index = index;
+        [workers addObject:worker];
+    }
+    _workers = [workers copy];
+
+    for (BFWorkStealingWorker *worker in _workers) {
+        NSThread *thread = [[NSThread alloc] initWithTarget:self selector:@selector(runWorker:) object:worker];
+        thread.name = [NSString stringWithFormat:@"bolts.work-stealing.%lu", (unsigned long)worker->_index];
+        thread.qualityOfService = NSQualityOfServiceUtility;
+        [thread start];
+    }
+
+    return self;
+}
+
+- (void)enqueue:(dispatch_block_t)block {
+    BFWorkStealingWorker *current = (__bridge BFWorkStealingWorker *)BFCurrentWorker;
+    BFWorkStealingWorker *worker = current;
+    if (!worker || worker->_pool != self) {
+        // Submitted from outside the pool; spread it round-robin.
+        NSUInteger next = atomic_fetch_add(&_nextWorker, 1);
+        worker = _workers[next % _workers.count];
+    }
+    [worker push:[block copy]];
+
+    // Paired with the idle count increment in `runWorker:`: either the idle worker sees this block when it looks
+    // again, or we see it idle and wake it. The fence keeps the load below from moving above the push.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&_idleWorkers) > 0) {
+        dispatch_semaphore_signal(_workAvailable);
+    }
+}
+
+- (nullable dispatch_block_t)nextBlockForWorker:(BFWorkStealingWorker *)worker {
+    dispatch_block_t block = [worker pop];
+    if (block) {
+        return block;
+    }
+
+    NSUInteger count = _workers.count;
+    for (NSUInteger offset = 1; offset < count; offset++) {
+        block = [_workers[(worker->_index + offset) % count] steal];
+        if (block) {
+            return block;
+        }
+    }
+    return nil;
+}
+
+- (void)runWorker:(BFWorkStealingWorker *)worker {
+    BFCurrentWorker = (__bridge void *)worker;
+
+    while (YES) {
+        dispatch_block_t block = [self nextBlockForWorker:worker];
+        if (!block) {
+            atomic_fetch_add(&_idleWorkers, 1);
+            block = [self nextBlockForWorker:worker];
+            if (!block) {
+                dispatch_semaphore_wait(_workAvailable, DISPATCH_TIME_FOREVER);
+            }
+            atomic_fetch_sub(&_idleWorkers, 1);
+        }
+
+        if (block) {
+            @autoreleasepool {
+                block();
+            }
+        }
+    }
+}
+
+@end
+
 @interface BFExecutor ()
 
 @property (nonatomic, copy) void(^block)(void(^block)(void));
@@ -98,6 +254,19 @@ __attribute__((noinline)) static size_t remaining_stack_size(size_t *restrict to
     return mainThreadExecutor;
 }
 
++ (instancetype)workStealingExecutor {
+    static BFExecutor *workStealingExecutor = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSUInteger workerCount = MAX([NSProcessInfo processInfo].activeProcessorCount, (NSUInteger)2);
+        BFWorkStealingPool *pool = [[BFWorkStealingPool alloc] initWithWorkerCount:workerCount];
+        workStealingExecutor = [self executorWithBlock:^void(void(^block)(void)) {
+            [pool enqueue:block];
+        }];
+    });
+    return workStealingExecutor;
+}
+
 + (instancetype)executorWithBlock:(void(^)(void(^block)(void)))block {
     return [[self alloc] initWithBlock:block];
 }
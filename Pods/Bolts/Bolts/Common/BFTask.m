@@ -11,6 +11,7 @@
 #import "BFTask.h"
 
 #import <libkern/OSAtomic.h>
+#import <stdatomic.h>
 
 #import "Bolts.h"
 
@@ -26,34 +27,66 @@ NSInteger const kBFMultipleErrorsError = 80175001;
 
 NSString *const BFTaskMultipleErrorsUserInfoKey = @"errors";
 
+/*!
+ The state of a task. A task moves from pending to completing exactly once, by whichever `trySet*` wins the
+ compare-and-swap, and from completing to one of the completed states once its result or error is published.
+ */
+typedef NS_ENUM(uint32_t, BFTaskState) {
+    BFTaskStatePending = 0,
+    BFTaskStateCompleting,
+    BFTaskStateSucceeded,
+    BFTaskStateFaulted,
+    BFTaskStateCancelled,
+};
+
+/*!
+ A node in a task's continuation stack. Continuations are only ever pushed, and the whole stack is taken at once
+ on completion, so a compare-and-swap on the head is enough (there is no pop, so no ABA problem).
+ */
+typedef struct BFContinuation {
+    struct BFContinuation *_Nullable next;
+    void *block; // A retained `dispatch_block_t`.
+} BFContinuation;
+
+// The head of the continuation stack once the continuations have run; later continuations run immediately.
+#define BFContinuationsClosed ((BFContinuation *)1)
+
 @interface BFTask () {
     id _result;
     NSError *_error;
+    _Atomic(uint32_t) _state;
+    _Atomic(BFContinuation *) _continuations;
+    _Atomic(bool) _hasWaiters;
 }
 
-@property (nonatomic, assign, readwrite, getter=isCancelled) BOOL cancelled;
-@property (nonatomic, assign, readwrite, getter=isFaulted) BOOL faulted;
-@property (nonatomic, assign, readwrite, getter=isCompleted) BOOL completed;
-
-@property (nonatomic, strong) NSObject *lock;
-@property (nonatomic, strong) NSCondition *condition;
-@property (nonatomic, strong) NSMutableArray *callbacks;
-
 @end
 
+// Blocking waits are rare (see `waitUntilFinished`), so all tasks share a condition, rather than each task allocating one.
+static NSCondition *BFTaskWaitCondition(void) {
+    static NSCondition *condition;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        condition = [[NSCondition alloc] init];
+    });
+    return condition;
+}
+
 @implementation BFTask
 
 #pragma mark - Initializer
 
-- (instancetype)init {
-    self = [super init];
-    if (!self) return self;
-
-    _lock = [[NSObject alloc] init];
-    _condition = [[NSCondition alloc] init];
-    _callbacks = [NSMutableArray array];
-
-    return self;
+- (void)dealloc {
+    // Continuations of a task that never completed.
+    BFContinuation *node = atomic_load_explicit(&_continuations, memory_order_acquire);
+    if (node == BFContinuationsClosed) {
+        return;
+    }
+    while (node) {
+        BFContinuation *next = node->next;
+        (void)(__bridge_transfer id)node->block;
+        free(node);
+        node = next;
+    }
 }
 
 - (instancetype)initWithResult:(nullable id)result {
@@ -103,22 +136,24 @@ NSString *const BFTaskMultipleErrorsUserInfoKey = @"errors";
         return [self taskWithResult:nil];
     }
 
-    __block int32_t cancelled = 0;
-    NSObject *lock = [[NSObject alloc] init];
-    NSMutableArray *errors = [NSMutableArray array];
+    // Copied, since it's read again once all of the tasks have completed.
+    NSArray<BFTask *> *subtasks = [tasks copy];
 
     BFTaskCompletionSource *tcs = [BFTaskCompletionSource taskCompletionSource];
-    for (BFTask *task in tasks) {
-        [task continueWithBlock:^id(BFTask *t) {
-            if (t.error) {
-                @synchronized (lock) {
-                    [errors addObject:t.error];
+    for (BFTask *task in subtasks) {
+        [task continueWithBlock:^id(BFTask * __unused t) {
+            if (OSAtomicDecrement32Barrier(&total) == 0) {
+                // All of the tasks have completed, so their errors can be collected here, without a lock per completion.
+                NSMutableArray *errors = [NSMutableArray array];
+                BOOL cancelled = NO;
+                for (BFTask *completedTask in subtasks) {
+                    if (completedTask.error) {
+                        [errors addObject:completedTask.error];
+                    } else if (completedTask.cancelled) {
+                        cancelled = YES;
+                    }
                 }
-            } else if (t.cancelled) {
-                OSAtomicIncrement32Barrier(&cancelled);
-            }
 
-            if (OSAtomicDecrement32Barrier(&total) == 0) {
                 if (errors.count > 0) {
                     if (errors.count == 1) {
                         tcs.error = [errors firstObject];
@@ -128,7 +163,7 @@ NSString *const BFTaskMultipleErrorsUserInfoKey = @"errors";
                                                          userInfo:@{ BFTaskMultipleErrorsUserInfoKey: errors }];
                         tcs.error = error;
                     }
-                } else if (cancelled > 0) {
+                } else if (cancelled) {
                     [tcs cancel];
                 } else {
                     tcs.result = nil;
@@ -231,82 +266,121 @@ NSString *const BFTaskMultipleErrorsUserInfoKey = @"errors";
 
 #pragma mark - Custom Setters/Getters
 
+- (BFTaskState)state {
+    return atomic_load_explicit(&_state, memory_order_acquire);
+}
+
 - (nullable id)result {
-    @synchronized(self.lock) {
-        return _result;
-    }
+    // `_result` is written before the completed state is stored (release), so it's safe to read once that's seen (acquire).
+    return self.state >= BFTaskStateSucceeded ? _result : nil;
 }
 
 - (BOOL)trySetResult:(nullable id)result {
-    @synchronized(self.lock) {
-        if (self.completed) {
-            return NO;
-        }
-        self.completed = YES;
-        _result = result;
-        [self runContinuations];
-        return YES;
+    if (![self beginCompletion]) {
+        return NO;
     }
+    _result = result;
+    [self finishCompletionWithState:BFTaskStateSucceeded];
+    return YES;
 }
 
 - (nullable NSError *)error {
-    @synchronized(self.lock) {
-        return _error;
-    }
+    return self.state >= BFTaskStateSucceeded ? _error : nil;
 }
 
 - (BOOL)trySetError:(NSError *)error {
-    @synchronized(self.lock) {
-        if (self.completed) {
-            return NO;
-        }
-        self.completed = YES;
-        self.faulted = YES;
-        _error = error;
-        [self runContinuations];
-        return YES;
+    if (![self beginCompletion]) {
+        return NO;
     }
+    _error = error;
+    [self finishCompletionWithState:BFTaskStateFaulted];
+    return YES;
 }
 
 - (BOOL)isCancelled {
-    @synchronized(self.lock) {
-        return _cancelled;
-    }
+    return self.state == BFTaskStateCancelled;
 }
 
 - (BOOL)isFaulted {
-    @synchronized(self.lock) {
-        return _faulted;
-    }
+    return self.state == BFTaskStateFaulted;
 }
 
 - (BOOL)trySetCancelled {
-    @synchronized(self.lock) {
-        if (self.completed) {
-            return NO;
-        }
-        self.completed = YES;
-        self.cancelled = YES;
-        [self runContinuations];
-        return YES;
+    if (![self beginCompletion]) {
+        return NO;
     }
+    [self finishCompletionWithState:BFTaskStateCancelled];
+    return YES;
 }
 
 - (BOOL)isCompleted {
-    @synchronized(self.lock) {
-        return _completed;
+    return self.state >= BFTaskStateSucceeded;
+}
+
+// Returns YES for exactly one caller, which must then publish the result and call `finishCompletionWithState:`.
+- (BOOL)beginCompletion {
+    uint32_t expected = BFTaskStatePending;
+    return atomic_compare_exchange_strong_explicit(&_state, &expected, BFTaskStateCompleting,
+                                                   memory_order_acquire, memory_order_relaxed);
+}
+
+- (void)finishCompletionWithState:(BFTaskState)state {
+    // Sequentially consistent, as are the store of `_hasWaiters` and the loads of `_state` in `waitUntilFinished`:
+    // either the waiter sees the task completed, or we see the waiter and wake it. The waiter checks the state
+    // holding the condition's lock, so the broadcast can't come between its check and its wait.
+    atomic_store(&_state, state);
+    if (atomic_load(&_hasWaiters)) {
+        NSCondition *condition = BFTaskWaitCondition();
+        [condition lock];
+        [condition broadcast];
+        [condition unlock];
     }
+    [self runContinuations];
 }
 
-- (void)runContinuations {
-    @synchronized(self.lock) {
-        [self.condition lock];
-        [self.condition broadcast];
-        [self.condition unlock];
-        for (void (^callback)(void) in self.callbacks) {
-            callback();
+/*!
+ Pushes a continuation to run on completion.
+
+ @return NO if the task's continuations have already run; the caller must then run the block itself.
+ */
+- (BOOL)addContinuation:(dispatch_block_t)block {
+    BFContinuation *head = atomic_load_explicit(&_continuations, memory_order_acquire);
+    if (head == BFContinuationsClosed) {
+        return NO;
+    }
+
+    BFContinuation *node = malloc(sizeof(BFContinuation));
+    node->block = (__bridge_retained void *)[block copy];
+    do {
+        if (head == BFContinuationsClosed) {
+            (void)(__bridge_transfer id)node->block;
+            free(node);
+            return NO;
         }
-        [self.callbacks removeAllObjects];
+        node->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&_continuations, &head, node,
+                                                    memory_order_release, memory_order_acquire));
+    return YES;
+}
+
+- (void)runContinuations {
+    BFContinuation *node = atomic_exchange_explicit(&_continuations, BFContinuationsClosed, memory_order_acq_rel);
+
+    // The stack has the most recent continuation first; run them in the order they were added.
+    BFContinuation *ordered = NULL;
+    while (node) {
+        BFContinuation *next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+    }
+
+    while (ordered) {
+        BFContinuation *next = ordered->next;
+        dispatch_block_t block = (__bridge_transfer dispatch_block_t)ordered->block;
+        free(ordered);
+        block();
+        ordered = next;
     }
 }
 
@@ -355,16 +429,10 @@ NSString *const BFTaskMultipleErrorsUserInfoKey = @"errors";
         }
     };
 
-    BOOL completed;
-    @synchronized(self.lock) {
-        completed = self.completed;
-        if (!completed) {
-            [self.callbacks addObject:[^{
-                [executor execute:executionBlock];
-            } copy]];
-        }
-    }
-    if (completed) {
+    BOOL added = [self addContinuation:^{
+        [executor execute:executionBlock];
+    }];
+    if (!added) {
         [executor execute:executionBlock];
     }
 
@@ -419,35 +487,29 @@ NSString *const BFTaskMultipleErrorsUserInfoKey = @"errors";
         [self warnOperationOnMainThread];
     }
 
-    @synchronized(self.lock) {
-        if (self.completed) {
-            return;
-        }
-        [self.condition lock];
+    if (self.completed) {
+        return;
     }
-    // TODO: (nlutsenko) Restructure this to use Bolts-Swift thread access synchronization architecture
-    // In the meantime, it's absolutely safe to get `_completed` aka an ivar, as long as it's a `BOOL` aka less than word size.
-    while (!_completed) {
-        [self.condition wait];
+
+    atomic_store(&_hasWaiters, true);
+    NSCondition *condition = BFTaskWaitCondition();
+    [condition lock];
+    // Not `self.completed`: an acquire load could be ordered before the store of `_hasWaiters` above.
+    while (atomic_load(&_state) < BFTaskStateSucceeded) {
+        [condition wait];
     }
-    [self.condition unlock];
+    [condition unlock];
 }
 
 #pragma mark - NSObject
 
 - (NSString *)description {
-    // Acquire the data from the locked properties
-    BOOL completed;
-    BOOL cancelled;
-    BOOL faulted;
-    NSString *resultDescription = nil;
-
-    @synchronized(self.lock) {
-        completed = self.completed;
-        cancelled = self.cancelled;
-        faulted = self.faulted;
-        resultDescription = completed ? [NSString stringWithFormat:@" result = %@", self.result] : @"";
-    }
+    // Read the state once, so the fields are consistent with each other.
+    BFTaskState state = self.state;
+    BOOL completed = state >= BFTaskStateSucceeded;
+    BOOL cancelled = state == BFTaskStateCancelled;
+    BOOL faulted = state == BFTaskStateFaulted;
+    NSString *resultDescription = completed ? [NSString stringWithFormat:@" result = %@", _result] : @"";
 
     // Description string includes status information and, if available, the
     // result since in some ways this is what a promise actually "is".
@@ -90,6 +90,7 @@ open class MessagesCollectionViewFlowLayout: UICollectionViewFlowLayout {
     
     private func setupObserver() {
         NotificationCenter.default.addObserver(self, selector: #selector(MessagesCollectionViewFlowLayout.handleOrientationChange(_:)), name: UIDevice.orientationDidChangeNotification, object: nil)
+        NotificationCenter.default.addObserver(self, selector: #selector(MessagesCollectionViewFlowLayout.handleContentSizeCategoryChange(_:)), name: UIContentSizeCategory.didChangeNotification, object: nil)
     }
 
     // MARK: - Attributes
@@ -123,6 +124,10 @@ open class MessagesCollectionViewFlowLayout: UICollectionViewFlowLayout {
     }
 
     open override func invalidationContext(forBoundsChange newBounds: CGRect) -> UICollectionViewLayoutInvalidationContext {
+        if shouldInvalidateLayout(forBoundsChange: newBounds) {
+            // The item width is changing; the cached sizes are for the old width.
+            textMessageSizeCalculators().forEach { $0.removeAllCachedSizes() }
+        }
         let context = super.invalidationContext(forBoundsChange: newBounds)
         guard let flowLayoutContext = context as? UICollectionViewFlowLayoutInvalidationContext else { return context }
         flowLayoutContext.invalidateFlowLayoutDelegateMetrics = shouldInvalidateLayout(forBoundsChange: newBounds)
@@ -134,6 +139,12 @@ open class MessagesCollectionViewFlowLayout: UICollectionViewFlowLayout {
         invalidateLayout()
     }
 
+    @objc
+    private func handleContentSizeCategoryChange(_ notification: Notification) {
+        textMessageSizeCalculators().forEach { $0.removeAllCachedSizes() }
+        invalidateLayout()
+    }
+
     // MARK: - Cell Sizing
 
     lazy open var textMessageSizeCalculator = TextMessageSizeCalculator(layout: self)
@@ -254,6 +265,19 @@ open class MessagesCollectionViewFlowLayout: UICollectionViewFlowLayout {
         messageSizeCalculators().forEach { $0.outgoingAccessoryViewPadding = newPadding }
     }
 
+    /// Measures the text of the given messages on a background queue, so that laying them out finds their
+    /// sizes cached. Call on the main queue, once the collection view has its width.
+    public func warmSizeCache(for messages: [MessageType]) {
+        textMessageSizeCalculator.warmSizeCache(for: messages.filter { if case .text = $0.kind { return true }; return false })
+        attributedTextMessageSizeCalculator.warmSizeCache(for: messages.filter { if case .attributedText = $0.kind { return true }; return false })
+        emojiMessageSizeCalculator.warmSizeCache(for: messages.filter { if case .emoji = $0.kind { return true }; return false })
+    }
+
+    /// Get the `TextMessageSizeCalculator`s, which cache the sizes they measure
+    open func textMessageSizeCalculators() -> [TextMessageSizeCalculator] {
+        return [textMessageSizeCalculator, attributedTextMessageSizeCalculator, emojiMessageSizeCalculator]
+    }
+
     /// Get all `MessageSizeCalculator`s
     open func messageSizeCalculators() -> [MessageSizeCalculator] {
         return [textMessageSizeCalculator, attributedTextMessageSizeCalculator, emojiMessageSizeCalculator, photoMessageSizeCalculator, videoMessageSizeCalculator, locationMessageSizeCalculator]
@@ -29,7 +29,77 @@ open class TextMessageSizeCalculator: MessageSizeCalculator {
     public var incomingMessageLabelInsets = UIEdgeInsets(top: 7, left: 18, bottom: 7, right: 14)
     public var outgoingMessageLabelInsets = UIEdgeInsets(top: 7, left: 14, bottom: 7, right: 18)
 
-    public var messageLabelFont = UIFont.preferredFont(forTextStyle: .body)
+    public var messageLabelFont = UIFont.preferredFont(forTextStyle: .body) {
+        didSet {
+            removeAllCachedSizes()
+        }
+    }
+
+    /// Measured text sizes, keyed by the message and everything else the measurement depends on.
+    /// Accessed from the main queue, and from `sizeCacheQueue` when warming.
+    private struct SizeCacheKey: Hashable {
+        let messageId: String
+        let maxWidth: CGFloat
+        let contentSizeCategory: UIContentSizeCategory
+    }
+
+    private var sizeCache = [SizeCacheKey: CGSize]()
+    private let sizeCacheLock = NSLock()
+    private let sizeCacheQueue = DispatchQueue(label: "MessageKit.TextMessageSizeCalculator", qos: .userInitiated)
+
+    /// Removes all cached text sizes. The layout calls this when the item width or the content size category changes.
+    public func removeAllCachedSizes() {
+        sizeCacheLock.lock()
+        sizeCache.removeAll()
+        sizeCacheLock.unlock()
+    }
+
+    /// Measures the text of the given messages on a background queue, so that laying them out later
+    /// finds their sizes cached. Call on the main queue, once the collection view has its width.
+    open func warmSizeCache(for messages: [MessageType], completion: (() -> Void)? = nil) {
+        let contentSizeCategory = currentContentSizeCategory
+        let work: [(key: SizeCacheKey, text: NSAttributedString)] = messages.compactMap { message in
+            guard let text = attributedText(for: message) else { return nil }
+            let key = SizeCacheKey(messageId: message.messageId, maxWidth: messageContainerMaxWidth(for: message), contentSizeCategory: contentSizeCategory)
+            return (key, text)
+        }
+
+        sizeCacheQueue.async {
+            for item in work where self.cachedSize(for: item.key) == nil {
+                self.cache(size: self.labelSize(for: item.text, considering: item.key.maxWidth), for: item.key)
+            }
+            if let completion = completion {
+                DispatchQueue.main.async(execute: completion)
+            }
+        }
+    }
+
+    private var currentContentSizeCategory: UIContentSizeCategory {
+        return messagesLayout.collectionView?.traitCollection.preferredContentSizeCategory ?? .unspecified
+    }
+
+    private func cachedSize(for key: SizeCacheKey) -> CGSize? {
+        sizeCacheLock.lock()
+        defer { sizeCacheLock.unlock() }
+        return sizeCache[key]
+    }
+
+    private func cache(size: CGSize, for key: SizeCacheKey) {
+        sizeCacheLock.lock()
+        sizeCache[key] = size
+        sizeCacheLock.unlock()
+    }
+
+    private func attributedText(for message: MessageType) -> NSAttributedString? {
+        switch message.kind {
+        case .attributedText(let text):
+            return text
+        case .text(let text), .emoji(let text):
+            return NSAttributedString(string: text, attributes: [.font: messageLabelFont])
+        default:
+            return nil
+        }
+    }
 
     internal func messageLabelInsets(for message: MessageType) -> UIEdgeInsets {
         let dataSource = messagesLayout.messagesDataSource
@@ -47,19 +117,18 @@ open class TextMessageSizeCalculator: MessageSizeCalculator {
         let maxWidth = messageContainerMaxWidth(for: message)
 
         var messageContainerSize: CGSize
-        let attributedText: NSAttributedString
-
-        switch message.kind {
-        case .attributedText(let text):
-            attributedText = text
-        case .text(let text), .emoji(let text):
-            attributedText = NSAttributedString(string: text, attributes: [.font: messageLabelFont])
-        default:
-            fatalError("messageContainerSize received unhandled MessageDataType: \(message.kind)")
+        let key = SizeCacheKey(messageId: message.messageId, maxWidth: maxWidth, contentSizeCategory: currentContentSizeCategory)
+
+        if let cachedSize = cachedSize(for: key) {
+            messageContainerSize = cachedSize
+        } else {
+            guard let attributedText = attributedText(for: message) else {
+                fatalError("messageContainerSize received unhandled MessageDataType: \(message.kind)")
+            }
+            messageContainerSize = labelSize(for: attributedText, considering: maxWidth)
+            cache(size: messageContainerSize, for: key)
         }
 
-        messageContainerSize = labelSize(for: attributedText, considering: maxWidth)
-
         let messageInsets = messageLabelInsets(for: message)
         messageContainerSize.width += messageInsets.horizontal
         messageContainerSize.height += messageInsets.vertical
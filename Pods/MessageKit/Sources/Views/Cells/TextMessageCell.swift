@@ -54,6 +54,7 @@ open class TextMessageCell: MessageContentCell {
         super.prepareForReuse()
         messageLabel.attributedText = nil
         messageLabel.text = nil
+        messageLabel.messageId = nil
     }
 
     open override func setupSubviews() {
@@ -71,6 +72,7 @@ open class TextMessageCell: MessageContentCell {
         let enabledDetectors = displayDelegate.enabledDetectors(for: message, at: indexPath, in: messagesCollectionView)
 
         messageLabel.configure {
+            messageLabel.messageId = message.messageId
             messageLabel.enabledDetectors = enabledDetectors
             for detector in enabledDetectors {
                 let attributes = displayDelegate.detectorAttributes(for: detector, and: message, at: indexPath)
@@ -53,10 +53,18 @@ open class MessageLabel: UILabel {
     
     private var isConfiguring: Bool = false
 
+    /// The detection this label is waiting on from `MessageTextDetection`, if any.
+    private var pendingDetection: MessageTextDetection.Request?
+
     // MARK: - Public Properties
 
     open weak var delegate: MessageLabelDelegate?
 
+    /// The id of the message being shown. When set, data detector matches are found off the main queue,
+    /// once per message, and cached; the detected ranges are applied when they arrive. When nil, the text
+    /// is scanned synchronously each time it is parsed.
+    open var messageId: String?
+
     open var enabledDetectors: [DetectorType] = [] {
         didSet {
             setTextStorage(attributedText, shouldParse: true)
@@ -206,6 +214,7 @@ open class MessageLabel: UILabel {
     private func setTextStorage(_ newText: NSAttributedString?, shouldParse: Bool) {
 
         guard let newText = newText, newText.length > 0 else {
+            pendingDetection = nil
             textStorage.setAttributedString(NSAttributedString())
             setNeedsDisplay()
             return
@@ -312,11 +321,27 @@ open class MessageLabel: UILabel {
     // MARK: - Parsing Text
 
     private func parse(text: NSAttributedString) -> [NSTextCheckingResult] {
-        guard enabledDetectors.isEmpty == false else { return [] }
-        let checkingTypes = enabledDetectors.reduce(0) { $0 | $1.textCheckingType.rawValue }
-        let detector = try? NSDataDetector(types: checkingTypes)
+        guard enabledDetectors.isEmpty == false else {
+            pendingDetection = nil
+            return []
+        }
+        let checkingTypes = MessageTextDetection.checkingTypes(for: enabledDetectors)
         let range = NSRange(location: 0, length: text.length)
-        let matches = detector?.matches(in: text.string, options: [], range: range) ?? []
+        let matches: [NSTextCheckingResult]
+
+        if let messageId = messageId {
+            let request = MessageTextDetection.Request(messageId: messageId, text: text.string, checkingTypes: checkingTypes)
+            if let cachedMatches = MessageTextDetection.shared.cachedMatches(for: request) {
+                pendingDetection = nil
+                matches = cachedMatches
+            } else {
+                // Show the plain text now; the detected ranges get applied when the background pass finishes.
+                requestMatches(for: request)
+                matches = []
+            }
+        } else {
+            matches = MessageTextDetection.shared.matches(in: text.string, checkingTypes: checkingTypes)
+        }
 
         guard enabledDetectors.contains(.url) else {
             return matches
@@ -334,6 +359,40 @@ open class MessageLabel: UILabel {
         return results
     }
 
+    private func requestMatches(for request: MessageTextDetection.Request) {
+        // Configuring a cell sets the text more than once; only ask once.
+        guard pendingDetection != request else { return }
+        pendingDetection = request
+
+        MessageTextDetection.shared.findMatches(for: [request]) { [weak self] in
+            // The label may have been reused for another message by now.
+            guard let strongSelf = self, strongSelf.pendingDetection == request else { return }
+            strongSelf.pendingDetection = nil
+            strongSelf.setTextStorage(strongSelf.attributedText, shouldParse: true)
+            strongSelf.setNeedsDisplay()
+        }
+    }
+
+    /// Finds the data detector matches for the given messages on a background queue, so that labels
+    /// showing them later find the matches cached. Only text, emoji and attributed text messages are scanned.
+    public static func warmDetectorCache(for messages: [MessageType], detectors: [DetectorType]) {
+        guard detectors.isEmpty == false else { return }
+        let checkingTypes = MessageTextDetection.checkingTypes(for: detectors)
+        let requests: [MessageTextDetection.Request] = messages.compactMap { message in
+            let text: String
+            switch message.kind {
+            case .text(let messageText), .emoji(let messageText):
+                text = messageText
+            case .attributedText(let attributedText):
+                text = attributedText.string
+            default:
+                return nil
+            }
+            return MessageTextDetection.Request(messageId: message.messageId, text: text, checkingTypes: checkingTypes)
+        }
+        MessageTextDetection.shared.findMatches(for: requests)
+    }
+
     private func setRangesForDetectors(in checkingResults: [NSTextCheckingResult]) {
 
         guard checkingResults.isEmpty == false else { return }
@@ -472,3 +531,83 @@ private enum MessageTextCheckingType {
     case link(URL?)
     case transitInfoComponents([NSTextCheckingKey: String]?)
 }
+
+/// Data detector state shared by all `MessageLabel`s. Creating an `NSDataDetector` and running it are both
+/// expensive, so detectors are reused per checking type mask, and each message's matches are found once,
+/// off the main queue, and cached by message id.
+internal final class MessageTextDetection {
+
+    static let shared = MessageTextDetection()
+
+    struct Request: Equatable {
+        let messageId: String
+        let text: String
+        let checkingTypes: UInt64
+
+        fileprivate var cacheKey: NSString {
+            return "\(checkingTypes):\(messageId)" as NSString
+        }
+    }
+
+    private final class Matches {
+        let text: String
+        let results: [NSTextCheckingResult]
+
+        init(text: String, results: [NSTextCheckingResult]) {
+            self.text = text
+            self.results = results
+        }
+    }
+
+    private var detectors = [UInt64: NSDataDetector]()
+    private let detectorsLock = NSLock()
+    private let matchesCache = NSCache<NSString, Matches>()
+    private let queue = DispatchQueue(label: "MessageKit.MessageTextDetection", qos: .userInitiated, attributes: .concurrent)
+
+    private init() {
+        matchesCache.countLimit = 2000
+    }
+
+    static func checkingTypes(for detectors: [DetectorType]) -> UInt64 {
+        return detectors.reduce(0) { $0 | $1.textCheckingType.rawValue }
+    }
+
+    /// `NSDataDetector` is immutable once created, and safe to use from several threads.
+    func detector(for checkingTypes: UInt64) -> NSDataDetector? {
+        detectorsLock.lock()
+        defer { detectorsLock.unlock() }
+
+        if let detector = detectors[checkingTypes] {
+            return detector
+        }
+        let detector = try? NSDataDetector(types: checkingTypes)
+        detectors[checkingTypes] = detector
+        return detector
+    }
+
+    func matches(in text: String, checkingTypes: UInt64) -> [NSTextCheckingResult] {
+        let range = NSRange(location: 0, length: (text as NSString).length)
+        return detector(for: checkingTypes)?.matches(in: text, options: [], range: range) ?? []
+    }
+
+    /// The cached matches for the request, if its message was scanned before with the same text.
+    func cachedMatches(for request: Request) -> [NSTextCheckingResult]? {
+        guard let matches = matchesCache.object(forKey: request.cacheKey), matches.text == request.text else {
+            return nil
+        }
+        return matches.results
+    }
+
+    /// Scans the requests that aren't cached yet, in order, on a background queue. The completion is called on the main queue.
+    func findMatches(for requests: [Request], completion: (() -> Void)? = nil) {
+        queue.async {
+            for request in requests where self.cachedMatches(for: request) == nil {
+                let results = self.matches(in: request.text, checkingTypes: request.checkingTypes)
+                self.matchesCache.setObject(Matches(text: request.text, results: results), forKey: request.cacheKey)
+            }
+            if let completion = completion {
+                DispatchQueue.main.async(execute: completion)
+            }
+        }
+    }
+}
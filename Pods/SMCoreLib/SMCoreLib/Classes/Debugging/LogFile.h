@@ -33,8 +33,18 @@
     }
 
 // Appends the string to the logfile. Prepends current date to the log message.
+// The message is copied into an in-memory ring buffer, and written to the file on a background queue-- when enough has accumulated, or periodically. The calling thread doesn't wait for the disk.
 + (void) write:(NSString *) message;
 
+// Synchronously writes any buffered messages to the log file and syncs the file to disk. Use this on crash/exit paths. This is also done automatically when the app goes into the background or terminates.
++ (void) flush;
+
+// Path of the file being written to. By default, LOGFILE in FileStorage.
++ (NSString *) path;
+
+// Writes what's buffered to the current file, and then switches to appending to the file at `path`, creating it if needed. E.g., so tests don't write into the app's log.
++ (void) setPath:(NSString *) path;
+
 + (void) redirectConsoleLogToDocumentFolder:(bool) clearRedirectLog;
 
 @end
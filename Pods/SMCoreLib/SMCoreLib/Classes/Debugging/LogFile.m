@@ -9,6 +9,31 @@
 #import "LogFile.h"
 #import "FileStorage.h"
 #import "UIDevice+Extras.h"
+#import <UIKit/UIKit.h>
+#import <os/lock.h>
+
+// Size of the in-memory ring buffer holding messages not yet written to the file.
+static const size_t kLogFileRingCapacity = 256 * 1024;
+
+// When this many bytes are buffered, a write to the file is started.
+static const size_t kLogFileFlushThreshold = 32 * 1024;
+
+// Buffered messages are written at least this often.
+static const int64_t kLogFileFlushIntervalSeconds = 2;
+
+@interface LogFile () {
+    NSString *path;
+    char *ring;
+    size_t ringStart; // index of the oldest buffered byte
+    size_t ringCount; // number of buffered bytes
+    BOOL drainPending;
+    os_unfair_lock ringLock;
+    
+    // All file writes happen on this queue.
+    dispatch_queue_t writeQueue;
+    dispatch_source_t flushTimer;
+}
+@end
 
 @implementation LogFile
 
@@ -16,43 +41,173 @@
 {
     // the instance of this class is stored here
     static LogFile *myInstance = nil;
+    static dispatch_once_t onceToken;
     
-    // check to see if an instance already exists
-    if (nil == myInstance) {
+    // Messages get written from many threads.
+    dispatch_once(&onceToken, ^{
         myInstance  = [[[self class] alloc] init];
         
-        NSString *logFileName = [FileStorage pathToItem: LOGFILE];
-        
         /*NSOutputStream *oStream = [[NSOutputStream alloc] initToFileAtPath:logFileName append:YES];
         [oStream open];
         */
         
-        // the writeData method of NSFileHandle doesn't create the file
-        // it doesn't already exist, so have to do something a little convoluted
-        
-        myInstance->fileHandle = [NSFileHandle fileHandleForWritingAtPath:logFileName];
-        if (nil == myInstance->fileHandle) {
-            // file didn't exist yet; so create it.
-            [[NSFileManager defaultManager] createFileAtPath:logFileName contents:nil attributes:nil];
-            
-            // Now open it!
-            myInstance->fileHandle = [NSFileHandle fileHandleForWritingAtPath:logFileName];
-        }
-        
-        // By default, the file pointer is initially positioned at the start 
-        // of the file.
-        [myInstance->fileHandle seekToEndOfFile];
+        [myInstance openFileAtPath:[FileStorage pathToItem: LOGFILE]];
 
         // This does not append to the file.
         //[dataToWrite writeToFile:logFileName atomically:NO encoding:NSUTF8StringEncoding error:nil];
 
         //[LogFile LocalInit:myInstance];
-    }
+        
+        [myInstance setupBuffering];
+    });
     
     // return the instance of this class
     return myInstance;
 }
 
+- (void) openFileAtPath: (NSString *) logFileName;
+{
+    path = [logFileName copy];
+    
+    // the writeData method of NSFileHandle doesn't create the file
+    // it doesn't already exist, so have to do something a little convoluted
+    
+    fileHandle = [NSFileHandle fileHandleForWritingAtPath:logFileName];
+    if (nil == fileHandle) {
+        // file didn't exist yet; so create it.
+        [[NSFileManager defaultManager] createFileAtPath:logFileName contents:nil attributes:nil];
+        
+        // Now open it!
+        fileHandle = [NSFileHandle fileHandleForWritingAtPath:logFileName];
+    }
+    
+    // By default, the file pointer is initially positioned at the start
+    // of the file.
+    [fileHandle seekToEndOfFile];
+}
+
+- (void) setupBuffering;
+{
+    ring = malloc(kLogFileRingCapacity);
+    ringStart = 0;
+    ringCount = 0;
+    drainPending = NO;
+    ringLock = OS_UNFAIR_LOCK_INIT;
+    
+    writeQueue = dispatch_queue_create("biz.SpasticMuffin.LogFile", DISPATCH_QUEUE_SERIAL);
+    
+    __weak LogFile *weakSelf = self;
+    flushTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, writeQueue);
+    dispatch_source_set_timer(flushTimer, dispatch_time(DISPATCH_TIME_NOW, kLogFileFlushIntervalSeconds * NSEC_PER_SEC), kLogFileFlushIntervalSeconds * NSEC_PER_SEC, NSEC_PER_SEC / 2);
+    dispatch_source_set_event_handler(flushTimer, ^{
+        [weakSelf drain];
+    });
+    dispatch_resume(flushTimer);
+    
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    [center addObserver:[self class] selector:@selector(flush) name:UIApplicationDidEnterBackgroundNotification object:nil];
+    [center addObserver:[self class] selector:@selector(flush) name:UIApplicationWillTerminateNotification object:nil];
+}
+
+// Called on any thread.
+- (void) appendBytes: (const void *) bytes length: (size_t) length;
+{
+    if (length > kLogFileRingCapacity) {
+        // Won't fit in the ring at all. Write it through, after what's already buffered.
+        NSData *data = [NSData dataWithBytes:bytes length:length];
+        dispatch_sync(writeQueue, ^{
+            [self drain];
+            [self->fileHandle writeData:data];
+        });
+        return;
+    }
+    
+    os_unfair_lock_lock(&ringLock);
+    
+    // The ring is full; wait for the writer to catch up. This should be rare.
+    while (kLogFileRingCapacity - ringCount < length) {
+        os_unfair_lock_unlock(&ringLock);
+        dispatch_sync(writeQueue, ^{
+            [self drain];
+        });
+        os_unfair_lock_lock(&ringLock);
+    }
+    
+    size_t end = (ringStart + ringCount) % kLogFileRingCapacity;
+    size_t firstPart = MIN(length, kLogFileRingCapacity - end);
+    memcpy(ring + end, bytes, firstPart);
+    memcpy(ring, (const char *) bytes + firstPart, length - firstPart);
+    ringCount += length;
+    
+    BOOL startDrain = NO;
+    if (ringCount >= kLogFileFlushThreshold && !drainPending) {
+        drainPending = YES;
+        startDrain = YES;
+    }
+    
+    os_unfair_lock_unlock(&ringLock);
+    
+    if (startDrain) {
+        dispatch_async(writeQueue, ^{
+            [self drain];
+        });
+    }
+}
+
+// Must be called on the writeQueue. Moves everything buffered to the file.
+- (void) drain;
+{
+    os_unfair_lock_lock(&ringLock);
+    
+    NSMutableData *data = nil;
+    if (ringCount > 0) {
+        data = [NSMutableData dataWithLength:ringCount];
+        size_t firstPart = MIN(ringCount, kLogFileRingCapacity - ringStart);
+        memcpy(data.mutableBytes, ring + ringStart, firstPart);
+        memcpy((char *) data.mutableBytes + firstPart, ring, ringCount - firstPart);
+    }
+    
+    ringStart = 0;
+    ringCount = 0;
+    drainPending = NO;
+    
+    os_unfair_lock_unlock(&ringLock);
+    
+    if (data) {
+        [fileHandle writeData:data];
+    }
+}
+
++ (void) flush;
+{
+    LogFile *lf = [LogFile sharedInstance];
+    dispatch_sync(lf->writeQueue, ^{
+        [lf drain];
+        [lf->fileHandle synchronizeFile];
+    });
+}
+
++ (NSString *) path;
+{
+    LogFile *lf = [LogFile sharedInstance];
+    __block NSString *result;
+    dispatch_sync(lf->writeQueue, ^{
+        result = lf->path;
+    });
+    return result;
+}
+
++ (void) setPath:(NSString *) path;
+{
+    LogFile *lf = [LogFile sharedInstance];
+    dispatch_sync(lf->writeQueue, ^{
+        [lf drain];
+        [lf->fileHandle synchronizeFile];
+        [lf->fileHandle closeFile];
+        [lf openFileAtPath:path];
+    });
+}
+
 // TODO: Don't want the log file to grow too too large. So, if the log file
 // gets too large, delete the first 1/2 of the lines of the file
 // before writing next log message.
@@ -101,9 +256,10 @@
     // 9/12/15; Adding date in higher level code that creates the message.
     // NSDate *date = [[NSDate alloc] init];
     
-    // Writes objects that have descriptions.
+    // Buffers objects that have descriptions. Previously, this wrote and synchronized the file for every message.
     void (^writeObject)(id) = ^(id objectToWrite) {
-        [lf->fileHandle writeData:[[objectToWrite description]dataUsingEncoding:NSUTF8StringEncoding]];
+        NSData *data = [[objectToWrite description] dataUsingEncoding:NSUTF8StringEncoding];
+        [lf appendBytes:data.bytes length:data.length];
         
         // 9/12/15; Not needed any more.
         //[lf->fileHandle writeData:[@"; " dataUsingEncoding:NSUTF8StringEncoding]];
@@ -111,8 +267,6 @@
     
     // writeObject(date);
     writeObject(dataString);
-
-    [lf->fileHandle synchronizeFile];
 }
 
 // Requires plist setting:  UIFileSharingEnabled set to YES
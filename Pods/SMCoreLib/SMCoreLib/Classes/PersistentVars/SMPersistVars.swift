@@ -9,6 +9,7 @@
 // A generalization over NSUserDefaults, and KeyChain (and later, perhaps iCloud) to deal with  variables that persist across launches of an app.
 
 import Foundation
+import UIKit
 
 // The different persistent variable types have separate name spaces. I.e., you can use the same name (see init method below) in across user defaults and keychain.
 public enum SMPersistVarType {
@@ -30,6 +31,7 @@ open class SMPersistItem : NSObject {
     fileprivate  let initialValue:AnyObject!
     
     // 10/31/15; I've introduced this for performance reasons, and specifically for the KeyChain persistence type, but will use it for NS user defaults too just for generality.
+    // 10/19/19; This is now the value of record. For .userDefaults, sets archive the value and hand the data to SMPersistVars, which writes it in the background, coalescing changes. .keyChain sets are still written through. So, after the first read, reads don't touch NSUserDefaults or the KeyChain or unarchive.
     fileprivate var _cachedCurrentValue:AnyObject?
     
     public let persistType:SMPersistVarType
@@ -53,6 +55,10 @@ open class SMPersistItem : NSObject {
     
     // Reset just this value.
     open func reset() {
+        // Any pending write of this item would otherwise land after the removal below.
+        SMPersistVars.session().discardPendingWrite(of: self)
+        SMPersistVars.session().flush(synchronously: true)
+        
         switch (self.persistType) {
         case .userDefaults:
             SMPersistVars.session().resetUserDefaults(self.name)
@@ -105,22 +111,32 @@ open class SMPersistItem : NSObject {
         return defsStoredValue
     }
     
+    // The value is archived here, at set time, so a later change to a mutable value doesn't leak into the write. .userDefaults writes are write-behind: SMPersistVars writes the data on its next flush. .keyChain writes are write-through; those are credentials, and must not be lost if the app goes away before a flush.
     fileprivate func savePersistentValue(_ value:AnyObject!) -> Bool {
+        self._cachedCurrentValue = value
+        
         let archivedData = self.archiveValue(value)
         if nil == archivedData {
-            Log.error("savePersistentValue: Failed")
+            Log.error("savePersistentValue: Failed: name: \(self.name)")
             return false
-        } else {
+        }
+        
+        switch (self.persistType) {
+        case .userDefaults:
+            SMPersistVars.session().scheduleWrite(of: self, data: archivedData!)
+            
+        case .keyChain:
             self.savePersistentData(archivedData!)
-            return true
         }
+        
+        return true
     }
     
+    // For .userDefaults, called by SMPersistVars on its write queue; SMPersistVars synchronizes once after writing a batch.
     fileprivate func savePersistentData(_ data:Data!) {
         switch (self.persistType) {
         case .userDefaults:
             UserDefaults.standard.set(data, forKey: self.name)
-            SMPersistVars.session().saveUserDefaults()
             
         case .keyChain:
             KeyChain.setSecureData(data, forService: self.name, account: KEYCHAIN_ACCOUNT)
@@ -160,9 +176,7 @@ open class SMPersistItem : NSObject {
             }
             else {
                 if persistentValue is NSData {
-                    let unarchivedValue = self.unarchiveValue((persistentValue! as! Data))
-                    Log.msg("name: \(self.name); \(String(describing: unarchivedValue)); type: \(type(of: unarchivedValue))")
-                    returnValue = unarchivedValue
+                    returnValue = self.unarchiveValue((persistentValue! as! Data))
                 }
                 else {
                     // Should be an Int or Bool; see [1] above.
@@ -177,7 +191,6 @@ open class SMPersistItem : NSObject {
         
         set {
             let _ = self.savePersistentValue(newValue)
-            let _ = self._cachedCurrentValue = newValue
         }
     }
     
@@ -401,7 +414,6 @@ open class SMPersistItemDict : SMPersistItem, SMMutableDictionaryDelegate {
     open var dictValue:NSMutableDictionary! {
         get {
             let dict = self.cachedOrArchivedValue as! SMMutableDictionary
-            Log.msg("\(NSStringFromClass(type(of: dict)))")
             dict.delegate = self
             return dict
         }
@@ -495,12 +507,80 @@ open class SMPersistItemArray : SMPersistItem {
     // The names of all the defaults. Just held in RAM so we can do a reset of all of the items stored in NSUserDefaults and KeyChain if needed.
     fileprivate var userDefaultNames = Set<String>()
     fileprivate var keyChainNames = Set<String>()
+    
+    // Archived values of .userDefaults items changed since the last flush; the last set of an item wins. Keyed by identity; SMPersistItem's are long-lived (typically static).
+    private var dirtyItems = [ObjectIdentifier: (item: SMPersistItem, data: Data)]()
+    private var flushScheduled = false
+    private let dirtyLock = NSLock()
+    
+    // Serial, so writes land in the order they were flushed.
+    private let writeQueue = DispatchQueue(label: "SMPersistVars.write", qos: .utility)
+    
+    // How long changes are coalesced before being written.
+    open var flushDelay: TimeInterval = 0.5
 
     fileprivate override init() {
         super.init()
+        
+        // So pending changes are on disk before the app can be suspended or killed.
+        let center = NotificationCenter.default
+        center.addObserver(self, selector: #selector(flushForApplicationState), name: UIApplication.willResignActiveNotification, object: nil)
+        center.addObserver(self, selector: #selector(flushForApplicationState), name: UIApplication.didEnterBackgroundNotification, object: nil)
+        center.addObserver(self, selector: #selector(flushForApplicationState), name: UIApplication.willTerminateNotification, object: nil)
+    }
+    
+    @objc private func flushForApplicationState() {
+        self.flush(synchronously: true)
+    }
+    
+    fileprivate func scheduleWrite(of item: SMPersistItem, data: Data) {
+        dirtyLock.lock()
+        dirtyItems[ObjectIdentifier(item)] = (item, data)
+        let scheduleFlush = !flushScheduled
+        flushScheduled = true
+        dirtyLock.unlock()
+        
+        if scheduleFlush {
+            DispatchQueue.main.asyncAfter(deadline: .now() + flushDelay) {
+                self.flush()
+            }
+        }
+    }
+    
+    fileprivate func discardPendingWrite(of item: SMPersistItem) {
+        dirtyLock.lock()
+        dirtyItems[ObjectIdentifier(item)] = nil
+        dirtyLock.unlock()
+    }
+    
+    // Writes the values set since the last flush on a background queue, with a single NSUserDefaults synchronize. With synchronously true, returns only after all writes so far are done.
+    open func flush(synchronously: Bool = false) {
+        dirtyLock.lock()
+        let writes = Array(dirtyItems.values)
+        dirtyItems.removeAll()
+        flushScheduled = false
+        dirtyLock.unlock()
+        
+        if writes.count > 0 {
+            writeQueue.async {
+                for write in writes {
+                    write.item.savePersistentData(write.data)
+                }
+                self.saveUserDefaults()
+            }
+        }
+        
+        if synchronously {
+            writeQueue.sync {}
+        }
     }
     
     open func reset() {
+        dirtyLock.lock()
+        dirtyItems.removeAll()
+        dirtyLock.unlock()
+        self.flush(synchronously: true)
+        
         for name in self.userDefaultNames {
             self.resetUserDefaults(name)
         }
@@ -0,0 +1,246 @@
+//
+//  LinkDataCache.swift
+//  SMLinkPreview
+//
+//  Created by Christopher G Prince on 10/19/19.
+//
+
+import Foundation
+import CommonCrypto
+
+// An on-disk cache of LinkData, keyed by normalized URL, and of preview images, stored once per distinct content.
+// Within `timeToLive` a cached LinkData is used without touching the network. After that, it's revalidated with a conditional request for the page (ETag/Last-Modified) and used again if the page hasn't changed; otherwise it's fetched again from the sources. Images are downloaded again after `timeToLive`.
+public class LinkDataCache {
+    struct Entry: Codable {
+        let linkData: LinkData
+        var validated: Date
+        var etag: String?
+        var lastModified: String?
+        
+        // Different URLs can share an entry, through normalization; the caller gets back the URL it asked for.
+        func linkData(for url: URL) -> LinkData {
+            return LinkData(url: url, title: linkData.title, description: linkData.description, image: linkData.image, icon: linkData.icon)
+        }
+    }
+    
+    struct ImageEntry: Codable {
+        // Content hash, which names the image file.
+        let hash: String
+        let validated: Date
+    }
+    
+    public var timeToLive: TimeInterval = 7 * 24 * 60 * 60
+    
+    private let linkDataDirectory: URL
+    private let imagesDirectory: URL
+    private let imageIndexURL: URL
+    
+    // Image URL (absolute string) -> its image file. Accessed under imageLock.
+    private var imageIndex = [String: ImageEntry]()
+    private let imageLock = NSLock()
+    
+    private let queue = DispatchQueue(label: "SMLinkPreview.LinkDataCache", qos: .userInitiated)
+    private let session: URLSession
+    
+    public static let defaultDirectory: URL = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask)[0].appendingPathComponent("SMLinkPreview")
+    
+    public init(directory: URL = LinkDataCache.defaultDirectory, session: URLSession = URLSession.shared) {
+        linkDataDirectory = directory.appendingPathComponent("LinkData")
+        imagesDirectory = directory.appendingPathComponent("Images")
+        imageIndexURL = imagesDirectory.appendingPathComponent("index.json")
+        self.session = session
+        
+        try? FileManager.default.createDirectory(at: linkDataDirectory, withIntermediateDirectories: true, attributes: nil)
+        try? FileManager.default.createDirectory(at: imagesDirectory, withIntermediateDirectories: true, attributes: nil)
+        
+        if let data = try? Data(contentsOf: imageIndexURL),
+            let index = try? JSONDecoder().decode([String: ImageEntry].self, from: data) {
+            imageIndex = index
+        }
+    }
+    
+    // MARK: LinkData
+    
+    // `fetch` gets the LinkData from the sources, on a cache miss, or when the page has changed. If fetching fails, a stale cached LinkData is better than none, and is returned. `accept` is applied to cached LinkData, e.g., the current linkDataFilter. The completion is called on a background queue.
+    public func linkData(for url: URL, accept: ((LinkData)->(Bool))?, fetch: @escaping (_ completion: @escaping (LinkData?)->())->(), completion: @escaping (LinkData?)->()) {
+        guard let key = url.normalizedForCache().map({ LinkDataCache.hash(Data($0.utf8)) }) else {
+            fetch(completion)
+            return
+        }
+        
+        queue.async {
+            guard var entry = self.entry(forKey: key), accept?(entry.linkData) ?? true else {
+                self.fetchAndStore(url: url, key: key, stale: nil, fetch: fetch, completion: completion)
+                return
+            }
+            
+            if Date().timeIntervalSince(entry.validated) < self.timeToLive {
+                completion(entry.linkData(for: url))
+                return
+            }
+            
+            self.revalidate(url: url, entry: entry) { unchanged in
+                if unchanged {
+                    entry.validated = Date()
+                    self.queue.async {
+                        self.store(entry: entry, forKey: key)
+                    }
+                    completion(entry.linkData(for: url))
+                }
+                else {
+                    self.fetchAndStore(url: url, key: key, stale: entry, fetch: fetch, completion: completion)
+                }
+            }
+        }
+    }
+    
+    public func removeAll() {
+        queue.sync {
+            try? FileManager.default.removeItem(at: linkDataDirectory)
+            try? FileManager.default.createDirectory(at: linkDataDirectory, withIntermediateDirectories: true, attributes: nil)
+        }
+        
+        imageLock.lock()
+        imageIndex.removeAll()
+        try? FileManager.default.removeItem(at: imagesDirectory)
+        try? FileManager.default.createDirectory(at: imagesDirectory, withIntermediateDirectories: true, attributes: nil)
+        imageLock.unlock()
+    }
+    
+    private func fetchAndStore(url: URL, key: String, stale: Entry?, fetch: @escaping (_ completion: @escaping (LinkData?)->())->(), completion: @escaping (LinkData?)->()) {
+        fetch { linkData in
+            guard let linkData = linkData else {
+                completion(stale?.linkData(for: url))
+                return
+            }
+            
+            var entry = Entry(linkData: linkData, validated: Date(), etag: nil, lastModified: nil)
+            self.queue.async {
+                self.store(entry: entry, forKey: key)
+                completion(linkData)
+            }
+            
+            // Don't make the caller wait on the validators; they only matter once the entry is stale.
+            self.validators(for: url, entry: nil) { _, etag, lastModified in
+                guard etag != nil || lastModified != nil else {
+                    return
+                }
+                entry.etag = etag
+                entry.lastModified = lastModified
+                self.queue.async {
+                    self.store(entry: entry, forKey: key)
+                }
+            }
+        }
+    }
+    
+    // Conditional HEAD request for the page.
+    private func revalidate(url: URL, entry: Entry, completion: @escaping (_ unchanged: Bool)->()) {
+        guard entry.etag != nil || entry.lastModified != nil else {
+            completion(false)
+            return
+        }
+        
+        validators(for: url, entry: entry) { status, etag, lastModified in
+            // Not all servers honor conditional HEAD requests; an unchanged ETag means the same.
+            let unchanged = status == 304 || (status == 200 && etag != nil && etag == entry.etag)
+            completion(unchanged)
+        }
+    }
+    
+    private func validators(for url: URL, entry: Entry?, completion: @escaping (_ status: Int?, _ etag: String?, _ lastModified: String?)->()) {
+        var request = URLRequest(url: url)
+        request.httpMethod = "HEAD"
+        request.cachePolicy = .reloadIgnoringLocalCacheData
+        
+        if let etag = entry?.etag {
+            request.addValue(etag, forHTTPHeaderField: "If-None-Match")
+        }
+        if let lastModified = entry?.lastModified {
+            request.addValue(lastModified, forHTTPHeaderField: "If-Modified-Since")
+        }
+        
+        let dataTask = session.dataTask(with: request) { _, response, error in
+            guard error == nil, let response = response as? HTTPURLResponse else {
+                completion(nil, nil, nil)
+                return
+            }
+            
+            let headers = response.allHeaderFields
+            completion(response.statusCode, headers["Etag"] as? String ?? headers["ETag"] as? String, headers["Last-Modified"] as? String)
+        }
+        
+        dataTask.resume()
+    }
+    
+    // Only call these on `queue`.
+    private func entryURL(forKey key: String) -> URL {
+        return linkDataDirectory.appendingPathComponent(key + ".json")
+    }
+    
+    private func entry(forKey key: String) -> Entry? {
+        guard let data = try? Data(contentsOf: entryURL(forKey: key)) else {
+            return nil
+        }
+        return try? JSONDecoder().decode(Entry.self, from: data)
+    }
+    
+    private func store(entry: Entry, forKey key: String) {
+        guard let data = try? JSONEncoder().encode(entry) else {
+            return
+        }
+        try? data.write(to: entryURL(forKey: key), options: .atomic)
+    }
+    
+    // MARK: Images
+    
+    // The image data for the URL, downloading it only if it's not cached, or was cached more than `timeToLive` ago. Popular images shared by many links, e.g., site icons, are stored once. Synchronous, so call off the main thread for remote URLs.
+    public func imageData(for url: URL) -> Data? {
+        if url.isFileURL {
+            return try? Data(contentsOf: url)
+        }
+        
+        let urlKey = url.absoluteString
+        imageLock.lock()
+        let cached = imageIndex[urlKey]
+        imageLock.unlock()
+        
+        let cachedData = cached.flatMap { try? Data(contentsOf: imagesDirectory.appendingPathComponent($0.hash)) }
+        if let cached = cached, let cachedData = cachedData,
+            Date().timeIntervalSince(cached.validated) < timeToLive {
+            return cachedData
+        }
+        
+        // If downloading fails, a stale image is better than none.
+        guard let data = try? Data(contentsOf: url) else {
+            return cachedData
+        }
+        
+        let hash = LinkDataCache.hash(data)
+        let imageURL = imagesDirectory.appendingPathComponent(hash)
+        
+        imageLock.lock()
+        if !FileManager.default.fileExists(atPath: imageURL.path) {
+            try? data.write(to: imageURL, options: .atomic)
+        }
+        imageIndex[urlKey] = ImageEntry(hash: hash, validated: Date())
+        let index = imageIndex
+        imageLock.unlock()
+        
+        queue.async {
+            if let indexData = try? JSONEncoder().encode(index) {
+                try? indexData.write(to: self.imageIndexURL, options: .atomic)
+            }
+        }
+        
+        return data
+    }
+    
+    static func hash(_ data: Data) -> String {
+        var digest = [UInt8](repeating: 0, count: Int(CC_SHA256_DIGEST_LENGTH))
+        data.withUnsafeBytes { (buffer: UnsafeRawBufferPointer) in
+            _ = CC_SHA256(buffer.baseAddress, CC_LONG(buffer.count), &digest)
+        }
+        return digest.map { String(format: "%02x", $0) }.joined()
+    }
+}
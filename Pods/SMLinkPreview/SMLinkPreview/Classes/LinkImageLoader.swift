@@ -0,0 +1,126 @@
+//
+//  LinkImageLoader.swift
+//  SMLinkPreview
+//
+//  Created by Christopher G Prince on 10/19/19.
+//
+
+import UIKit
+import ImageIO
+
+// Loads LinkData images and icons off the main thread, decoded at (at most) the size they'll be displayed at. Decoded images are kept in a shared memory cache, so showing the same link again, or the same site icon for another link, doesn't touch the disk or network.
+public class LinkImageLoader {
+    public class Request {
+        private var cancelled = false
+        private let lock = NSLock()
+        
+        fileprivate var isCancelled: Bool {
+            lock.lock()
+            defer { lock.unlock() }
+            return cancelled
+        }
+        
+        // After this, the completion won't be called.
+        public func cancel() {
+            lock.lock()
+            cancelled = true
+            lock.unlock()
+        }
+    }
+    
+    public static let session = LinkImageLoader()
+    
+    private let cache = NSCache<NSString, UIImage>()
+    
+    // Bounded so a fast scroll doesn't start dozens of downloads at once; cancelled requests are skipped before they start.
+    private let queue: OperationQueue = {
+        let queue = OperationQueue()
+        queue.name = "SMLinkPreview.LinkImageLoader"
+        queue.maxConcurrentOperationCount = 4
+        queue.qualityOfService = .userInitiated
+        return queue
+    }()
+    
+    init() {
+        // In bytes, approximately-- see `cost(of:)`.
+        cache.totalCostLimit = 50 * 1024 * 1024
+    }
+    
+    private static func key(url: URL, maxPixelSize: CGFloat) -> NSString {
+        return "\(Int(maxPixelSize)):\(url.absoluteString)" as NSString
+    }
+    
+    // Synchronous; memory cache only.
+    public func cachedImage(for url: URL, maxPixelSize: CGFloat) -> UIImage? {
+        return cache.object(forKey: LinkImageLoader.key(url: url, maxPixelSize: maxPixelSize))
+    }
+    
+    // `maxPixelSize` is in pixels, not points, and applies to the larger dimension of the image. The completion is called on the main thread, unless the request is cancelled first.
+    @discardableResult
+    public func loadImage(for url: URL, maxPixelSize: CGFloat, completion: @escaping (UIImage?)->()) -> Request {
+        let request = Request()
+        let key = LinkImageLoader.key(url: url, maxPixelSize: maxPixelSize)
+        
+        if let image = cache.object(forKey: key) {
+            completion(image)
+            return request
+        }
+        
+        queue.addOperation {
+            guard !request.isCancelled else {
+                return
+            }
+            
+            var image: UIImage?
+            if let data = PreviewManager.session.imageData(for: url) {
+                image = LinkImageLoader.decode(data: data, maxPixelSize: maxPixelSize)
+            }
+            
+            if let image = image {
+                self.cache.setObject(image, forKey: key, cost: LinkImageLoader.cost(of: image))
+            }
+            
+            DispatchQueue.main.async {
+                guard !request.isCancelled else {
+                    return
+                }
+                completion(image)
+            }
+        }
+        
+        return request
+    }
+    
+    public func removeAll() {
+        cache.removeAllObjects()
+    }
+    
+    // Downsamples without decoding the full sized image first, and forces decoding here rather than at first draw on the main thread.
+    static func decode(data: Data, maxPixelSize: CGFloat) -> UIImage? {
+        let sourceOptions = [kCGImageSourceShouldCache: false] as CFDictionary
+        guard let source = CGImageSourceCreateWithData(data as CFData, sourceOptions) else {
+            return nil
+        }
+        
+        let thumbnailOptions = [
+            kCGImageSourceCreateThumbnailFromImageAlways: true,
+            kCGImageSourceCreateThumbnailWithTransform: true,
+            kCGImageSourceShouldCacheImmediately: true,
+            kCGImageSourceThumbnailMaxPixelSize: max(maxPixelSize, 1)
+        ] as CFDictionary
+        
+        if let cgImage = CGImageSourceCreateThumbnailAtIndex(source, 0, thumbnailOptions) {
+            return UIImage(cgImage: cgImage)
+        }
+        
+        // E.g., formats ImageIO can't thumbnail, such as some .ico files.
+        return UIImage(data: data)
+    }
+    
+    private static func cost(of image: UIImage) -> Int {
+        guard let cgImage = image.cgImage else {
+            return 1
+        }
+        return cgImage.bytesPerRow * cgImage.height
+    }
+}
@@ -19,6 +19,10 @@ public class LinkPreview: UIView {
     public var textAndIconAction:(()->())?
     private var haveImage: Bool = false
     private var doneSetup = false
+    private var imageRequest: LinkImageLoader.Request?
+    
+    // From the nib; setup zeroes the icon width when there's a large image or no icon.
+    private var defaultIconContainerWidth: CGFloat?
     
     public enum LoadedImage {
         case large(UIImage)
@@ -57,8 +61,14 @@ public class LinkPreview: UIView {
     }
     
     /// The image is passed back in the form of a callback to allow for asynchronous image loading if needed.
-    // Image data are loaded from the linkData icon/image URL's, if non-nil. Those URL's can refer to either local or remote files.
+    // Image data are loaded from the linkData icon/image URL's, if non-nil. Those URL's can refer to either local or remote files. They're loaded in the background, so the callback comes later, on the main thread-- unless the images are already in memory. Until then the layout assumes the image will load, and falls back to the icon if it doesn't.
     public func setup(with linkData: LinkData, callback:((_ image: LoadedImage?)->())? = nil) {
+        cancelImageLoading()
+        
+        if defaultIconContainerWidth == nil {
+            defaultIconContainerWidth = iconContainerWidth.constant
+        }
+        
         title.numberOfLines = Int(PreviewManager.session.config.maxNumberTitleLines)
         title.text = linkData.title
         url.text = linkData.url.urlWithoutScheme()
@@ -68,44 +78,85 @@ public class LinkPreview: UIView {
             forceScheme = .https
         }
         
-        var result:LoadedImage?
+        let iconURL = linkData.icon?.attemptForceScheme(forceScheme)
+        image.image = nil
+        icon.image = nil
         
-        if let imageURL = linkData.image,
-            let data = try? Data(contentsOf: imageURL.attemptForceScheme(forceScheme)) {
-            haveImage = true
-            image.image = UIImage(data: data)
-            if let image = image.image {
-                result = .large(image)
-            }
-            applyCornerRounding(view: contentView)
-            iconContainerWidth.constant = 0
-            layoutIfNeeded()
-            frame.size.height = textAndIconContainer.frame.height + image.frame.height
+        guard let imageURL = linkData.image?.attemptForceScheme(forceScheme) else {
+            setupWithoutImage(iconURL: iconURL, callback: callback)
+            return
         }
-        else {
-            haveImage = false
-
-            // No image; just have text area (title, URL) below.
-            applyCornerRounding(view: textAndIconContainer)
+        
+        layoutWithImage()
+        imageRequest = LinkImageLoader.session.loadImage(for: imageURL, maxPixelSize: LinkPreview.pixelSize(for: bounds.size, default: UIScreen.main.bounds.size)) { [weak self] loadedImage in
+            guard let self = self else { return }
+            self.imageRequest = nil
             
-            if let iconURL = linkData.icon {
-                if let data = try? Data(contentsOf: iconURL.attemptForceScheme(forceScheme)) {
-                    icon.image = UIImage(data: data)
-                    if let icon = icon.image {
-                        result = .icon(icon)
-                    }
-                }
+            if let loadedImage = loadedImage {
+                self.image.image = loadedImage
+                callback?(.large(loadedImage))
             }
             else {
-                iconContainerWidth.constant = 0
+                self.setupWithoutImage(iconURL: iconURL, callback: callback)
             }
+        }
+    }
+    
+    // Call when this preview is about to be reused for another link, or goes away; pending image loads won't call back.
+    public func cancelImageLoading() {
+        imageRequest?.cancel()
+        imageRequest = nil
+    }
+    
+    private func setupWithoutImage(iconURL: URL?, callback:((_ image: LoadedImage?)->())?) {
+        layoutWithoutImage(haveIcon: iconURL != nil)
+        
+        guard let iconURL = iconURL else {
+            callback?(nil)
+            return
+        }
+        
+        imageRequest = LinkImageLoader.session.loadImage(for: iconURL, maxPixelSize: LinkPreview.pixelSize(for: icon.bounds.size, default: CGSize(width: 60, height: 60))) { [weak self] loadedIcon in
+            guard let self = self else { return }
+            self.imageRequest = nil
             
-            imageHeight.constant = 0
-            layoutIfNeeded()
-            frame.size.height = textAndIconContainer.frame.height
+            self.icon.image = loadedIcon
+            if let loadedIcon = loadedIcon {
+                callback?(.icon(loadedIcon))
+            }
+            else {
+                callback?(nil)
+            }
         }
+    }
+    
+    private func layoutWithImage() {
+        haveImage = true
+        removeCornerRounding(view: textAndIconContainer)
+        applyCornerRounding(view: contentView)
+        iconContainerWidth.constant = 0
+        layoutIfNeeded()
+        frame.size.height = textAndIconContainer.frame.height + image.frame.height
+    }
+
+    // No image; just have text area (title, URL) below.
+    private func layoutWithoutImage(haveIcon: Bool) {
+        haveImage = false
+        removeCornerRounding(view: contentView)
+        applyCornerRounding(view: textAndIconContainer)
+        iconContainerWidth.constant = haveIcon ? defaultIconContainerWidth ?? 0 : 0
+        imageHeight.constant = 0
+        layoutIfNeeded()
+        frame.size.height = textAndIconContainer.frame.height
+    }
         
-        callback?(result)
+    // Views aren't always laid out yet when setup is called.
+    private static func pixelSize(for size: CGSize, default defaultSize: CGSize) -> CGFloat {
+        var points = max(size.width, size.height)
+        if points <= 0 {
+            points = max(defaultSize.width, defaultSize.height)
+        }
+        return points * UIScreen.main.scale
     }
 
     override public func layoutSubviews() {
@@ -124,6 +175,12 @@ public class LinkPreview: UIView {
         view.layer.borderWidth = 1
     }
     
+    func removeCornerRounding(view: UIView) {
+        view.layer.cornerRadius = 0
+        view.clipsToBounds = false
+        view.layer.borderWidth = 0
+    }
+    
     @IBAction func textAndIconAction(_ sender: Any) {
         textAndIconAction?()
     }
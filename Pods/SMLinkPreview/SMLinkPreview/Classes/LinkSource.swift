@@ -7,7 +7,7 @@
 
 import Foundation
 
-public struct LinkData {    
+public struct LinkData: Codable {
     public let url: URL
     public let title: String?
     public let description: String?
@@ -48,6 +48,49 @@ public struct APIKey {
 public protocol LinkSource {
     static var requestKeyName: String? {get}
     init?(apiKey: APIKey?)
-    func getLinkData(url: URL, completion: @escaping (LinkData?)->())
+    
+    // requestId identifies this one call, for cancelLinkData(requestId:). Concurrent calls for the same url have different requestId's.
+    func getLinkData(url: URL, requestId: UUID, completion: @escaping (LinkData?)->())
+    
+    // Called when another source has already answered the request. The completion of the cancelled request can still be called, e.g., with nil; it's ignored.
+    func cancelLinkData(requestId: UUID)
+}
+
+public extension LinkSource {
+    func getLinkData(url: URL, completion: @escaping (LinkData?)->()) {
+        getLinkData(url: url, requestId: UUID(), completion: completion)
+    }
+    
+    func cancelLinkData(requestId: UUID) {
+    }
+}
+
+// Tracks a source's in-flight data tasks by request, so they can be cancelled.
+public class LinkSourceDataTasks {
+    private var dataTasks = [UUID: URLSessionDataTask]()
+    private let lock = NSLock()
+    
+    public init() {}
+    
+    // Resumes the data task.
+    public func start(_ dataTask: URLSessionDataTask, for requestId: UUID) {
+        lock.lock()
+        dataTasks[requestId] = dataTask
+        lock.unlock()
+        dataTask.resume()
+    }
+    
+    public func finished(requestId: UUID) {
+        lock.lock()
+        dataTasks[requestId] = nil
+        lock.unlock()
+    }
+    
+    public func cancel(requestId: UUID) {
+        lock.lock()
+        let dataTask = dataTasks.removeValue(forKey: requestId)
+        lock.unlock()
+        dataTask?.cancel()
+    }
 }
 
@@ -7,13 +7,27 @@
 
 import Foundation
 
+// How the LinkSource's are used for a request. In all cases, sources are started in the order they were added, and the first LinkData passing the linkDataFilter is the result.
+public enum ProviderStrategy {
+    // Start the next source only after the one before it fails.
+    case sequential
+    
+    // Start the next source when the one before it fails, or after `delay` seconds without an answer, whichever comes first. Sources still running when one answers are cancelled.
+    case hedged(delay: TimeInterval)
+    
+    // Start all sources at once. Sources still running when one answers are cancelled.
+    case race
+}
+
 public struct PreviewConfiguration {
     public let alwaysUseHTTPS: Bool // Use https for all remote image loading? Default is true because otherwise app needs ATS set to allow insecure loading. This is not relevant for local image loading.
     public let maxNumberTitleLines: UInt // 0 means unlimited
+    public let providerStrategy: ProviderStrategy
     
-    public init(alwaysUseHTTPS: Bool = true, maxNumberTitleLines: UInt = 0) {
+    public init(alwaysUseHTTPS: Bool = true, maxNumberTitleLines: UInt = 0, providerStrategy: ProviderStrategy = .sequential) {
         self.alwaysUseHTTPS = alwaysUseHTTPS
         self.maxNumberTitleLines = maxNumberTitleLines
+        self.providerStrategy = providerStrategy
     }
 }
 
@@ -24,6 +38,9 @@ public class PreviewManager {
     public static let session = PreviewManager()
     public var config = PreviewConfiguration()
     
+    // Caches LinkData fetched by `getLinkData(url:completion:)`, and preview images. Set to nil to always use the network.
+    public var cache: LinkDataCache? = LinkDataCache()
+    
     // Use this to apply a filtering constraint on the LinkData returned by the API souurce. e.g., require that an image or an icon is present.
     public var linkDataFilter: ((LinkData)->(Bool))?
     
@@ -37,49 +54,147 @@ public class PreviewManager {
         sources = []
     }
     
+    // The completion is called on the main thread.
     public func getLinkData(url: URL, completion: @escaping (LinkData?)->()) {
-        getLinkDataAux(sources: sources, url: url, completion: completion)
+        guard let cache = cache else {
+            getLinkData(url: url, from: sources, completion: completion)
+            return
+        }
+        
+        let sources = self.sources
+        cache.linkData(for: url, accept: linkDataFilter, fetch: { fetchCompletion in
+            self.getLinkData(url: url, from: sources, callbackQueue: nil, completion: fetchCompletion)
+        }, completion: { linkData in
+            DispatchQueue.main.async {
+                completion(linkData)
+            }
+        })
     }
     
-    func onMainThread(completion: @escaping ()->()) {
-        if Thread.isMainThread {
-            completion()
+    // Image data for a LinkData image or icon URL, local or remote. Synchronous.
+    public func imageData(for url: URL) -> Data? {
+        if let cache = cache {
+            return cache.imageData(for: url)
         }
-        else {
-            DispatchQueue.main.sync {
-                completion()
+        return try? Data(contentsOf: url)
+    }
+    
+    // As above, but using the given sources instead of those added. The config and linkDataFilter still apply.
+    public func getLinkData(url: URL, from sources: [LinkSource], completion: @escaping (LinkData?)->()) {
+        getLinkData(url: url, from: sources, callbackQueue: DispatchQueue.main, completion: completion)
+    }
+    
+    // With a nil callbackQueue, the completion is called on a background queue.
+    private func getLinkData(url: URL, from sources: [LinkSource], callbackQueue: DispatchQueue?, completion: @escaping (LinkData?)->()) {
+        let request = LinkDataRequest(sources: sources, url: url, strategy: config.providerStrategy, filter: linkDataFilter) { linkData in
+            if let callbackQueue = callbackQueue {
+                callbackQueue.async {
+                    completion(linkData)
+                }
+            }
+            else {
+                completion(linkData)
             }
         }
+        request.start()
     }
+}
+
+// A single getLinkData request across the sources. The request keeps itself alive until its sources have answered.
+private class LinkDataRequest {
+    private let sources: [LinkSource]
+    private let url: URL
+    private let strategy: ProviderStrategy
+    private let filter: ((LinkData)->(Bool))?
+    private let completion: (LinkData?)->()
     
-    func getLinkDataAux(sources: [LinkSource], url: URL, completion: @escaping (LinkData?)->()) {
-        if sources.count == 0 {
-            onMainThread {completion(nil)}
-        }
-        else {
-            let source = sources[0]
-            let tail = sources.count > 1 ? Array(sources[1...sources.count-1]) : [LinkSource]()
-            source.getLinkData(url: url) {[unowned self] linkData in
-                guard let linkData = linkData else {
-                    // With a failure, try next as failover method(s).
-                    self.getLinkDataAux(sources: tail, url: url, completion: completion)
-                    return
-                }
-                
-                guard let filter = self.linkDataFilter else {
-                    // This is not a failure: There's just no filter. Return what we found!
-                    self.onMainThread {completion(linkData)}
-                    return
-                }
-                
-                if filter(linkData) {
-                    self.onMainThread {completion(linkData)}
+    // Identifies this request to the sources, so cancelling doesn't affect other requests for the same url.
+    private let requestId = UUID()
+    
+    // All state is accessed on this queue.
+    private let queue = DispatchQueue(label: "SMLinkPreview.LinkDataRequest")
+    private var nextSource = 0
+    private var running = Set<Int>()
+    private var finished = false
+    
+    init(sources: [LinkSource], url: URL, strategy: ProviderStrategy, filter: ((LinkData)->(Bool))?, completion: @escaping (LinkData?)->()) {
+        self.sources = sources
+        self.url = url
+        self.strategy = strategy
+        self.filter = filter
+        self.completion = completion
+    }
+    
+    func start() {
+        queue.async {
+            if case .race = self.strategy {
+                while self.nextSource < self.sources.count {
+                    self.startNextSource()
                 }
-                else {
-                    // linkData didn't meet the filter constraint-- try next.
-                    self.getLinkDataAux(sources: tail, url: url, completion: completion)
+            }
+            else {
+                self.startNextSource()
+            }
+            
+            self.finishIfExhausted()
+        }
+    }
+    
+    private func startNextSource() {
+        guard !finished, nextSource < sources.count else {
+            return
+        }
+        
+        let index = nextSource
+        nextSource += 1
+        running.insert(index)
+        
+        sources[index].getLinkData(url: url, requestId: requestId) { linkData in
+            self.queue.async {
+                self.received(linkData: linkData, fromSource: index)
+            }
+        }
+        
+        if case .hedged(let delay) = strategy {
+            queue.asyncAfter(deadline: .now() + delay) {
+                // Only if the next source hasn't been started already, because of a failure.
+                if self.nextSource == index + 1 {
+                    self.startNextSource()
                 }
             }
         }
     }
+    
+    private func received(linkData: LinkData?, fromSource index: Int) {
+        running.remove(index)
+        guard !finished else {
+            return
+        }
+        
+        if let linkData = linkData, filter?(linkData) ?? true {
+            finish(linkData: linkData)
+            return
+        }
+        
+        // A failure, or linkData didn't meet the filter constraint-- try the next source as a failover.
+        startNextSource()
+        finishIfExhausted()
+    }
+    
+    private func finishIfExhausted() {
+        if !finished && running.isEmpty && nextSource >= sources.count {
+            finish(linkData: nil)
+        }
+    }
+    
+    private func finish(linkData: LinkData?) {
+        finished = true
+        
+        for index in running {
+            sources[index].cancelLinkData(requestId: requestId)
+        }
+        running.removeAll()
+        
+        completion(linkData)
+    }
 }
@@ -13,11 +13,12 @@ public class AdaSupportPreview: LinkSource {
     public static var requestKeyName: String?
     // Parameter must have scheme stripped off. E.g., slack.com
     let route = "https://previews.ada.support/?url="
+    let dataTasks = LinkSourceDataTasks()
     
     required public init?(apiKey: APIKey?) {
     }
     
-    public func getLinkData(url: URL, completion: @escaping (LinkData?) -> ()) {
+    public func getLinkData(url: URL, requestId: UUID, completion: @escaping (LinkData?) -> ()) {
         guard let urlWithoutScheme = url.urlWithoutScheme() else {
             completion(nil)
             return
@@ -31,6 +32,8 @@ public class AdaSupportPreview: LinkSource {
         
         let request = URLRequest(url: routeURL)
         let dataTask = URLSession.shared.dataTask(with: request) { data, response, error in
+            self.dataTasks.finished(requestId: requestId)
+            
             guard let data = data, error == nil else {
                 completion(nil)
                 return
@@ -81,6 +84,10 @@ public class AdaSupportPreview: LinkSource {
             completion(linkData)
         }
         
-        dataTask.resume()
+        dataTasks.start(dataTask, for: requestId)
+    }
+    
+    public func cancelLinkData(requestId: UUID) {
+        dataTasks.cancel(requestId: requestId)
     }
 }
@@ -12,11 +12,12 @@ import Foundation
 public class MicrolinkPreview: LinkSource {
     public static var requestKeyName: String?
     let route = "https://api.microlink.io/?url="
+    let dataTasks = LinkSourceDataTasks()
     
     required public init?(apiKey: APIKey?) {
     }
     
-    public func getLinkData(url: URL, completion: @escaping (LinkData?) -> ()) {
+    public func getLinkData(url: URL, requestId: UUID, completion: @escaping (LinkData?) -> ()) {
         let routeString = route + url.absoluteString
         guard let routeURL = URL(string: routeString) else {
             completion(nil)
@@ -25,6 +26,8 @@ public class MicrolinkPreview: LinkSource {
         
         let request = URLRequest(url: routeURL)
         let dataTask = URLSession.shared.dataTask(with: request) { data, response, error in
+            self.dataTasks.finished(requestId: requestId)
+            
             guard let data = data, error == nil else {
                 completion(nil)
                 return
@@ -64,6 +67,10 @@ public class MicrolinkPreview: LinkSource {
             completion(linkData)
         }
         
-        dataTask.resume()
+        dataTasks.start(dataTask, for: requestId)
+    }
+    
+    public func cancelLinkData(requestId: UUID) {
+        dataTasks.cancel(requestId: requestId)
     }
 }
@@ -13,6 +13,7 @@ public class MicrosoftURLPreview: LinkSource {
     public static var requestKeyName: String? = "Ocp-Apim-Subscription-Key"
     let apiKey: APIKey
     let route = "https://api.labs.cognitive.microsoft.com/urlpreview/v7.0/search?q="
+    let dataTasks = LinkSourceDataTasks()
     
     required public init?(apiKey: APIKey?) {
         guard let apiKey = apiKey else {
@@ -22,7 +23,7 @@ public class MicrosoftURLPreview: LinkSource {
         self.apiKey = apiKey
     }
     
-    public func getLinkData(url: URL, completion: @escaping (LinkData?) -> ()) {
+    public func getLinkData(url: URL, requestId: UUID, completion: @escaping (LinkData?) -> ()) {
         let routeString = route + url.absoluteString
         
         guard let routeURL = URL(string: routeString) else {
@@ -34,6 +35,8 @@ public class MicrosoftURLPreview: LinkSource {
         request.addValue(apiKey.value, forHTTPHeaderField: apiKey.requestKey)
         
         let dataTask = URLSession.shared.dataTask(with: request) { data, response, error in
+            self.dataTasks.finished(requestId: requestId)
+            
             guard let data = data, error == nil else {
                 completion(nil)
                 return
@@ -65,6 +68,10 @@ public class MicrosoftURLPreview: LinkSource {
             completion(linkData)
         }
         
-        dataTask.resume()
+        dataTasks.start(dataTask, for: requestId)
+    }
+    
+    public func cancelLinkData(requestId: UUID) {
+        dataTasks.cancel(requestId: requestId)
     }
 }
@@ -19,6 +19,36 @@ extension URL {
         return String(formattedURL.dropFirst().dropFirst())
     }
     
+    // The same page, however it was typed or shared: no scheme (http and https are treated alike), lower case host, no default port, "www." prefix, fragment or trailing slash, and query items sorted. Nil for file URLs.
+    func normalizedForCache() -> String? {
+        guard !isFileURL, let components = URLComponents(url: self, resolvingAgainstBaseURL: true),
+            var host = components.host?.lowercased(), host.count > 0 else {
+            return nil
+        }
+        
+        if host.hasPrefix("www.") {
+            host = String(host.dropFirst(4))
+        }
+        
+        var result = host
+        if let port = components.port, port != 80 && port != 443 {
+            result += ":\(port)"
+        }
+        
+        var path = components.percentEncodedPath
+        while path.hasSuffix("/") {
+            path = String(path.dropLast())
+        }
+        result += path
+        
+        if let queryItems = components.queryItems, queryItems.count > 0 {
+            let sorted = queryItems.sorted { ($0.name, $0.value ?? "") < ($1.name, $1.value ?? "") }
+            result += "?" + sorted.map { $0.value == nil ? $0.name : "\($0.name)=\($0.value!)" }.joined(separator: "&")
+        }
+        
+        return result
+    }
+    
     enum ForceScheme: String {
         case https
         case http
@@ -68,6 +68,33 @@ public class SBPlatformDestination: BaseDestination {
     private var sendingInProgress = false
     private var initialSending = true
 
+    // send unsent entries once the oldest is this old, even if below the points threshold. 0 disables.
+    public var sendingInterval: TimeInterval = 60
+    private var oldestUnsentEntry: Date?
+
+    // after a send fails, automatic sends wait this long after the last attempt. Starts at sendingInterval
+    // and doubles with each failure, up to maxSendingRetryInterval; 0 after a send succeeds.
+    public var maxSendingRetryInterval: TimeInterval = 60 * 60
+    private var sendingRetryInterval: TimeInterval = 0
+    private var lastSendAttempt: Date?
+
+    // the configuration of the sessions posting to serverURL
+    public var sessionConfiguration = URLSessionConfiguration.default
+
+    // each request carries at most this many bytes of log lines, so memory use is bounded
+    // regardless of how many entries are waiting to be sent
+    public var maxBatchBytes = 256 * 1024
+
+    // byte offset into the sending file of the first line not yet accepted by the server.
+    // Saved next to the sending file, so a relaunch doesn't send accepted batches again.
+    private var sendingOffset: UInt64 = 0
+    var sendingOffsetFileURL: URL {
+        return sendingFileURL.appendingPathExtension("offset")
+    }
+
+    // reading and encrypting batches happens here, so logging on the destination queue isn't held up
+    private let batchQueue = DispatchQueue(label: "swiftybeaver-sbplatform-batch", qos: .utility)
+
     // analytics
     var uuid = ""
 
@@ -176,23 +203,38 @@ public class SBPlatformDestination: BaseDestination {
             points += newPoints
             toNSLog("current sending points: \(points)")
 
-            if (points >= sendingPoints.threshold && points >= minAllowedThreshold) || points > maxAllowedThreshold {
+            let now = Date()
+            if oldestUnsentEntry == nil {
+                oldestUnsentEntry = now
+            }
+            let sinceLastAttempt = now.timeIntervalSince(lastSendAttempt ?? .distantPast)
+            let backingOff = sinceLastAttempt < sendingRetryInterval
+            let intervalElapsed = sendingInterval > 0 &&
+                now.timeIntervalSince(oldestUnsentEntry ?? now) >= sendingInterval &&
+                sinceLastAttempt >= sendingInterval
+
+            if backingOff {
+                toNSLog("last send failed; not sending again for \(sendingRetryInterval - sinceLastAttempt)s")
+
+            } else if (points >= sendingPoints.threshold && points >= minAllowedThreshold) || points > maxAllowedThreshold {
                 toNSLog("\(points) points is >= threshold")
                 // above threshold, send to server
                 sendNow()
 
+            } else if intervalElapsed {
+                toNSLog("\(points) points is below threshold but sending interval elapsed")
+                sendNow()
+
             } else if initialSending {
                 initialSending = false
                 // first logging at this session
-                // send if json file still contains old log entries
-                if let logEntries = logsFromFile(entriesFileURL) {
-                    let lines = logEntries.count
-                    if lines > 1 {
-                        var msg = "initialSending: \(points) points is below threshold "
-                        msg += "but json file already has \(lines) lines."
-                        toNSLog(msg)
-                        sendNow()
-                    }
+                // send if json file still contains old log entries; just check its size, no need to parse it
+                let size = fileSize(entriesFileURL)
+                if size > UInt64(str.utf8.count + 1) {
+                    var msg = "initialSending: \(points) points is below threshold "
+                    msg += "but json file already has \(size) bytes."
+                    toNSLog(msg)
+                    sendNow()
                 }
             }
         }
@@ -212,53 +254,117 @@ public class SBPlatformDestination: BaseDestination {
             if !renameJsonToSendFile() {
                 return
             }
+            setSendingOffset(0)
+            oldestUnsentEntry = nil
         }
 
         if !sendingInProgress {
             sendingInProgress = true
-            //let (jsonString, lines) = logsFromFile(sendingFileURL)
-            var lines = 0
+            lastSendAttempt = Date()
+            sendingOffset = loadSendingOffset()
+            sendNextBatch()
+        }
+    }
+
+    /// called on the destination queue when sending stops: after the last batch was accepted, or when one wasn't.
+    /// After a failure, automatic sends back off, so that e.g. while offline each log line doesn't re-read,
+    /// re-encrypt and re-post the first batch.
+    private func finishSending(ok: Bool) {
+        sendingInProgress = false
+        points = 0
+        if ok {
+            sendingRetryInterval = 0
+        } else if sendingRetryInterval == 0 {
+            sendingRetryInterval = min(sendingInterval > 0 ? sendingInterval : 60, maxSendingRetryInterval)
+        } else {
+            sendingRetryInterval = min(sendingRetryInterval * 2, maxSendingRetryInterval)
+        }
+    }
 
-            guard let logEntries = logsFromFile(sendingFileURL) else {
-                sendingInProgress = false
+    /// runs a block on the destination queue. Everything that touches the sending state (sendingInProgress,
+    /// sendingOffset, points) happens there; the batch queue only reads and encrypts.
+    private func onDestinationQueue(_ block: @escaping () -> Void) {
+        guard let queue = queue else {
+            toNSLog("Error! Destination has no queue.")
+            return
+        }
+        queue.async(execute: block)
+    }
+
+    /// called on the destination queue. Reads the next batch of lines from the sending file, encrypts and posts
+    /// it on the batch queue, and continues with the following batch once the server has accepted it.
+    /// The lines are already JSON, so they go into the payload as they are, without being parsed.
+    private func sendNextBatch() {
+        let offset = sendingOffset
+
+        // merge device and analytics dictionaries
+        let deviceDetailsDict = deviceDetails()
+        var analyticsDict = analytics(analyticsFileURL)
+        for key in deviceDetailsDict.keys {
+            analyticsDict[key] = deviceDetailsDict[key]
+        }
+
+        guard let deviceJSON = jsonStringFromDict(analyticsDict) else {
+            finishSending(ok: false)
+            return
+        }
+
+        batchQueue.async {
+            guard let batch = self.readBatch(self.sendingFileURL, from: offset, maxBytes: self.maxBatchBytes) else {
+                self.onDestinationQueue {
+                    self.finishSending(ok: false)
+                }
                 return
             }
 
-            lines = logEntries.count
-
-            if lines > 0 {
-                var payload = [String: Any]()
-                // merge device and analytics dictionaries
-                let deviceDetailsDict = deviceDetails()
+            guard batch.lines.count > 0 else {
+                self.onDestinationQueue {
+                    if batch.atEnd {
+                        _ = self.deleteFile(self.sendingFileURL)
+                        self.setSendingOffset(0)
+                        self.finishSending(ok: true)
+                    } else {
+                        // nothing sendable in this batch; skip over it
+                        self.setSendingOffset(batch.nextOffset)
+                        self.sendNextBatch()
+                    }
+                }
+                return
+            }
 
-                var analyticsDict = analytics(analyticsFileURL)
+            // Not compressed: the platform decrypts payload and parses it as JSON, and has no way to be told the
+            // plaintext is compressed. Batches are at most maxBatchBytes, so encrypting them as they are is bounded.
+            let payload = "{\"device\":" + deviceJSON + ",\"entries\":[" + batch.lines.joined(separator: ",") + "]}"
+            let lines = batch.lines.count
 
-                for key in deviceDetailsDict.keys {
-                    analyticsDict[key] = deviceDetailsDict[key]
+            self.toNSLog("Encrypting \(lines) log entries ...")
+            guard let encryptedStr = self.encrypt(payload) else {
+                self.onDestinationQueue {
+                    self.finishSending(ok: false)
                 }
-                payload["device"] = analyticsDict
-                payload["entries"] = logEntries
-
-                if let str = jsonStringFromDict(payload) {
-                    //toNSLog(str)  // uncomment to see full payload
-                    toNSLog("Encrypting \(lines) log entries ...")
-                    if let encryptedStr = encrypt(str) {
-                        var msg = "Sending \(lines) encrypted log entries "
-                        msg += "(\(encryptedStr.length) chars) to server ..."
-                        toNSLog(msg)
-                        sendToServerAsync(encryptedStr) { ok, _ in
-
-                            self.toNSLog("Sent \(lines) encrypted log entries to server, received ok: \(ok)")
-                            if ok {
-                                _ = self.deleteFile(self.sendingFileURL)
-                            }
-                            self.sendingInProgress = false
-                            self.points = 0
-                        }
+                return
+            }
+
+            var msg = "Sending \(lines) encrypted log entries "
+            msg += "(\(encryptedStr.length) chars) to server ..."
+            self.toNSLog(msg)
+
+            // sendToServerAsync can complete right here on the batch queue, if assembling the request fails
+            self.sendToServerAsync(encryptedStr) { ok, _ in
+                self.onDestinationQueue {
+                    self.toNSLog("Sent \(lines) encrypted log entries to server, received ok: \(ok)")
+                    if ok && !batch.atEnd {
+                        self.setSendingOffset(batch.nextOffset)
+                        self.sendNextBatch()
+                        return
                     }
+
+                    if ok {
+                        _ = self.deleteFile(self.sendingFileURL)
+                        self.setSendingOffset(0)
+                    }
+                    self.finishSending(ok: ok)
                 }
-            } else {
-                sendingInProgress = false
             }
         }
     }
@@ -275,7 +381,7 @@ public class SBPlatformDestination: BaseDestination {
             operationQueue.underlyingQueue = queue
 
             let session = URLSession(configuration:
-                URLSessionConfiguration.default,
+                sessionConfiguration,
                 delegate: nil, delegateQueue: operationQueue)
 
             toNSLog("assembling request ...")
@@ -314,8 +420,6 @@ public class SBPlatformDestination: BaseDestination {
             toNSLog("sending params: \(params)")
             toNSLog("sending ...")
 
-            sendingInProgress = true
-
             // send request async to server on destination queue
             let task = session.dataTask(with: request) { _, response, error in
                 var ok = false
@@ -405,6 +509,84 @@ public class SBPlatformDestination: BaseDestination {
         }
     }
 
+    /// sets and saves the offset of the first unsent line in the sending file; 0 removes the saved offset
+    func setSendingOffset(_ offset: UInt64) {
+        sendingOffset = offset
+        if offset == 0 {
+            if fileManager.fileExists(atPath: sendingOffsetFileURL.path) {
+                _ = deleteFile(sendingOffsetFileURL)
+            }
+        } else {
+            _ = saveToFile(String(offset), url: sendingOffsetFileURL, overwrite: true)
+        }
+    }
+
+    /// returns the saved offset of the first unsent line in the sending file, or 0 if there is none
+    func loadSendingOffset() -> UInt64 {
+        guard let str = try? String(contentsOf: sendingOffsetFileURL, encoding: .utf8),
+            let offset = UInt64(str.trimmingCharacters(in: .whitespacesAndNewlines)) else {
+            return 0
+        }
+        return offset
+    }
+
+    /// returns the size of a file in bytes, or 0 if it doesn't exist
+    func fileSize(_ url: URL) -> UInt64 {
+        guard let attributes = try? fileManager.attributesOfItem(atPath: url.path),
+            let size = attributes[.size] as? NSNumber else {
+            return 0
+        }
+        return size.uint64Value
+    }
+
+    /// reads whole lines, starting at a byte offset, from a file which has 1 json string per line.
+    /// Stops at the last line ending within maxBytes-- unless a single line is longer than that.
+    /// Lines that don't look like a json dict are skipped, as in logsFromFile.
+    func readBatch(_ url: URL, from offset: UInt64, maxBytes: Int) ->
+        (lines: [String], nextOffset: UInt64, atEnd: Bool)? {
+
+        guard let fileHandle = try? FileHandle(forReadingFrom: url) else {
+            toNSLog("Error! Could not read file \(url).")
+            return nil
+        }
+        defer {
+            fileHandle.closeFile()
+        }
+
+        let size = fileHandle.seekToEndOfFile()
+        guard offset < size else {
+            return ([], offset, true)
+        }
+        fileHandle.seek(toFileOffset: offset)
+
+        let newline = UInt8(ascii: "\n")
+        var data = fileHandle.readData(ofLength: maxBytes)
+        var lastNewline = data.lastIndex(of: newline)
+
+        // a single line longer than maxBytes; keep reading until its end
+        while lastNewline == nil && offset + UInt64(data.count) < size {
+            let more = fileHandle.readData(ofLength: maxBytes)
+            if more.isEmpty {
+                break
+            }
+            data.append(more)
+            lastNewline = data.lastIndex(of: newline)
+        }
+
+        let consumed = lastNewline.map { $0 - data.startIndex + 1 } ?? data.count
+        let nextOffset = offset + UInt64(consumed)
+
+        var lines = [String]()
+        for lineData in data.prefix(consumed).split(separator: newline) {
+            if lineData.first == UInt8(ascii: "{") && lineData.last == UInt8(ascii: "}"),
+                let line = String(data: lineData, encoding: .utf8) {
+                lines.append(line)
+            }
+        }
+
+        return (lines, nextOffset, nextOffset >= size)
+    }
+
     /// returns optional array of log dicts from a file which has 1 json string per line
     func logsFromFile(_ url: URL) -> [[String:Any]]? {
         var lines = 0
@@ -42,6 +42,15 @@ open class BatchUploadData {
     var totalUploadProgress: Progress?
     /// The flag that determines whether upload continues or not.
     var cancel: Bool = false
+    /// Serializes access to `finishArgs` and to the large file uploads, whose responses are all handled here. Nothing
+    /// waits on this queue, so no threads are parked while chunks are in flight.
+    let stateQueue = DispatchQueue(label: "com.dropbox.batch_upload_state_queue")
+    /// Reads file chunks ahead of the append that's in flight.
+    let chunkReadQueue = DispatchQueue(label: "com.dropbox.batch_upload_chunk_read_queue", qos: .utility, attributes: .concurrent)
+    /// Large files waiting for one of the `maxConcurrentLargeFileUploads` upload slots. Accessed on `stateQueue`.
+    var pendingLargeFileUploads: [LargeFileUpload] = []
+    /// The number of large files currently being uploaded. Accessed on `stateQueue`.
+    var activeLargeFileUploads = 0
     /// The container object that stores all upload / download task objects for cancelling.
 //    let taskStorage: DBTasksStorage!
     
@@ -63,3 +72,96 @@ open class BatchUploadData {
         
     }
 }
+
+///
+/// Tracks the chunked upload of one large file. Accessed on the batch's `stateQueue`.
+///
+class LargeFileUpload {
+    let fileUrl: URL
+    let fileSize: UInt64
+    let numberOfChunks: UInt64
+    /// Set once `upload_session/start` succeeds.
+    var sessionId: String?
+    /// The next chunk to send.
+    var chunkIndex: UInt64 = 0
+
+    private class ChunkRead {
+        var done = false
+        var data: Data?
+        var waiters: [(Data?) -> Void] = []
+    }
+
+    private var chunkReads: [UInt64: ChunkRead] = [:]
+
+    init(fileUrl: URL, fileSize: UInt64) {
+        self.fileUrl = fileUrl
+        self.fileSize = fileSize
+        var numberOfChunks = fileSize / fileChunkSize
+        if fileSize % fileChunkSize != 0 {
+            numberOfChunks += 1
+        }
+        self.numberOfChunks = numberOfChunks
+    }
+
+    func isLastChunk(_ index: UInt64) -> Bool {
+        return index == numberOfChunks - 1
+    }
+
+    /// Starts reading the chunk in the background, if it's not already read or being read.
+    func readAhead(chunk index: UInt64, uploadData: BatchUploadData) {
+        guard index < numberOfChunks, chunkReads[index] == nil else {
+            return
+        }
+
+        let read = ChunkRead()
+        chunkReads[index] = read
+
+        let offset = index * fileChunkSize
+        let length = Int(min(fileChunkSize, fileSize - offset))
+        let fileUrl = self.fileUrl
+
+        uploadData.chunkReadQueue.async {
+            var data: Data?
+            if let fileHandle = try? FileHandle(forReadingFrom: fileUrl) {
+                fileHandle.seek(toFileOffset: offset)
+                data = fileHandle.readData(ofLength: length)
+                fileHandle.closeFile()
+            }
+
+            if data?.count != length {
+                data = nil
+            }
+
+            uploadData.stateQueue.async {
+                read.done = true
+                read.data = data
+                let waiters = read.waiters
+                read.waiters = []
+                waiters.forEach { $0(data) }
+            }
+        }
+    }
+
+    /// Forgets chunks read ahead, so an upload that ended early doesn't keep them in memory. A read still in progress
+    /// only holds its chunk until it's done.
+    func discardChunks() {
+        chunkReads.removeAll()
+    }
+
+    /// Calls back on `stateQueue` with the chunk's data, or nil if it couldn't be read, and forgets it.
+    func chunk(_ index: UInt64, uploadData: BatchUploadData, completion: @escaping (Data?) -> Void) {
+        readAhead(chunk: index, uploadData: uploadData)
+        let read = chunkReads[index]!
+
+        let deliver: (Data?) -> Void = { data in
+            self.chunkReads[index] = nil
+            completion(data)
+        }
+
+        if read.done {
+            deliver(read.data)
+        } else {
+            read.waiters.append(deliver)
+        }
+    }
+}
@@ -7,6 +7,10 @@ import Foundation
 // 10 MB file chunk size
 let fileChunkSize: UInt64 = 10 * 1024 * 1024
 let timeoutInSec = 200
+// Large files uploaded at once in a batch. Each holds at most two chunks in memory: the one being sent and the next one.
+let maxConcurrentLargeFileUploads = 2
+// Retries of a single chunk after a rate limit, network or server error.
+let maxChunkRetries = 3
 
 extension FilesRoutes {
 
@@ -70,7 +74,9 @@ extension FilesRoutes {
                 let commitInfo = uploadData.fileUrlsToCommitInfo[fileUrl]!
                 let finishArg = Files.UploadSessionFinishArg(cursor: cursor, commit: commitInfo)
                 // store commit info for this file
-                uploadData.finishArgs.append(finishArg)
+                uploadData.stateQueue.sync {
+                    uploadData.finishArgs.append(finishArg)
+                }
             }
             else {
 //                uploadData.fileUrlsToRequestErrors[fileUrl] = error
@@ -82,98 +88,118 @@ extension FilesRoutes {
     
     func startUploadLargeFile(uploadData: BatchUploadData, fileUrl: URL, fileSize: UInt64) {
         uploadData.uploadGroup.enter()
-        let startBytes = 0
-        let endBytes = fileChunkSize
-        let fileChunkInputStream = DBChunkInputStream(fileUrl: fileUrl, startBytes: UInt(startBytes), endBytes: UInt(endBytes))
-        // use seperate continue upload queue so we don't block other files from
-        // commencing their upload
-        let chunkUploadContinueQueue = DispatchQueue(label: "chunk_upload_continue_queue")
-        // do not immediately close session
+        uploadData.stateQueue.async {
+            uploadData.pendingLargeFileUploads.append(LargeFileUpload(fileUrl: fileUrl, fileSize: fileSize))
+            self.startPendingLargeFileUploads(uploadData: uploadData)
+        }
+    }
 
-        self.uploadSessionStart(input: fileChunkInputStream).response(queue: chunkUploadContinueQueue, completionHandler: { result, error in
-            if let result = result {
-                let sessionId = result.sessionId
-                self.appendRemainingFileChunks(uploadData: uploadData, fileUrl: fileUrl, fileSize: fileSize, sessionId: sessionId)
-                let cursor = Files.UploadSessionCursor(sessionId: sessionId, offset: (fileSize))
-                let commitInfo = uploadData.fileUrlsToCommitInfo[fileUrl]!
-                let finishArg = Files.UploadSessionFinishArg(cursor: cursor, commit: commitInfo)
-                // Store commit info for this file
-                uploadData.finishArgs.append(finishArg)
-            } else {
-//                uploadData.fileUrlsToRequestErrors[fileUrl] = error
-                uploadData.uploadGroup.leave()
-            }
-//            uploadData.taskStorage.remove(task)
-        }).progress { progress in
-            self.executeProgressHandler(uploadData:uploadData, progress: progress)
+    // Call on `uploadData.stateQueue`.
+    func startPendingLargeFileUploads(uploadData: BatchUploadData) {
+        while uploadData.activeLargeFileUploads < maxConcurrentLargeFileUploads && !uploadData.pendingLargeFileUploads.isEmpty {
+            let upload = uploadData.pendingLargeFileUploads.removeFirst()
+            uploadData.activeLargeFileUploads += 1
+            self.uploadNextChunk(uploadData: uploadData, upload: upload)
         }
-        
-//        uploadData.taskStorage.add(task)
     }
 
-    func appendRemainingFileChunks(uploadData: BatchUploadData, fileUrl: URL, fileSize: UInt64, sessionId: String) {
-        // use seperate response queue so we don't block response thread
-        // with dispatch_semaphore_t
-        let chunkUploadResponseQueue = DispatchQueue(label: "chunk_upload_response_queue")
+    // Call on `uploadData.stateQueue` once a large file's upload is over, whether or not it succeeded. If any chunk failed,
+    // `upload_session/finish_batch` reports the error for that file.
+    func finishLargeFileUpload(uploadData: BatchUploadData, upload: LargeFileUpload) {
+        upload.discardChunks()
+        uploadData.activeLargeFileUploads -= 1
+        self.startPendingLargeFileUploads(uploadData: uploadData)
+        uploadData.uploadGroup.leave()
+    }
 
-        chunkUploadResponseQueue.async {
-            var numFileChunks = fileSize / fileChunkSize
-            if fileSize % fileChunkSize != 0 {
-                numFileChunks += 1
+    // Chunks of a file are sent one at a time, in order, as an upload session requires. While a chunk is in flight, the
+    // next one is read from disk. Call on `uploadData.stateQueue`.
+    func uploadNextChunk(uploadData: BatchUploadData, upload: LargeFileUpload) {
+        guard !uploadData.cancel else {
+            self.finishLargeFileUpload(uploadData: uploadData, upload: upload)
+            return
+        }
+
+        let index = upload.chunkIndex
+        upload.chunk(index, uploadData: uploadData) { data in
+            guard let data = data else {
+                self.finishLargeFileUpload(uploadData: uploadData, upload: upload)
+                return
             }
-            var totalBytesSent: UInt64 = 0
-            let chunkUploadFinished = DispatchSemaphore(value: 0)
-            // iterate through all remaining chunks and upload each one sequentially
-            for i in 1..<numFileChunks {
-                let startBytes = fileChunkSize * i
-                let endBytes = (i != numFileChunks - 1) ? fileChunkSize * (i + 1) : fileSize
-                let fileChunkInputStream = DBChunkInputStream(fileUrl: fileUrl, startBytes: UInt(startBytes), endBytes: UInt(endBytes))
-                totalBytesSent += fileChunkSize
-                let cursor = Files.UploadSessionCursor(sessionId: sessionId, offset: (totalBytesSent))
-                let shouldClose = (i != numFileChunks - 1) ? false : true
-                let shouldContinue = true
-                self.appendFileChunk(uploadData: uploadData, fileUrl: fileUrl, cursor: cursor, shouldClose: shouldClose, fileChunkInputStream: fileChunkInputStream, chunkUploadResponseQueue: chunkUploadResponseQueue, chunkUploadFinished: chunkUploadFinished, retryCount: 0, startBytes: startBytes, endBytes: endBytes, shouldContinue: shouldContinue)
-                // wait until each chunk upload completes before resuming loop iteration
-                _ = chunkUploadFinished.wait(timeout: DispatchTime.now() + .seconds(480))
-                if !shouldContinue {
-                    break
+
+            upload.readAhead(chunk: index + 1, uploadData: uploadData)
+            self.sendChunk(uploadData: uploadData, upload: upload, index: index, data: data, retryCount: 0)
+        }
+    }
+
+    func sendChunk(uploadData: BatchUploadData, upload: LargeFileUpload, index: UInt64, data: Data, retryCount: Int) {
+        // close session on final chunk
+        let shouldClose = upload.isLastChunk(index)
+
+        let retryOrFinish = { (delay: Double?) in
+            if let delay = delay, retryCount < maxChunkRetries {
+                uploadData.stateQueue.asyncAfter(deadline: .now() + delay) {
+                    self.sendChunk(uploadData: uploadData, upload: upload, index: index, data: data, retryCount: retryCount + 1)
                 }
+            } else {
+                self.finishLargeFileUpload(uploadData: uploadData, upload: upload)
             }
-            uploadData.uploadGroup.leave()
         }
-    }
-    
-    func appendFileChunk(uploadData: BatchUploadData, fileUrl: URL, cursor: Files.UploadSessionCursor, shouldClose: Bool, fileChunkInputStream: DBChunkInputStream, chunkUploadResponseQueue: DispatchQueue, chunkUploadFinished: DispatchSemaphore, retryCount: Int, startBytes: UInt64, endBytes: UInt64, shouldContinue: Bool) {
-        // close session on final append call
-        
-        self.uploadSessionAppendV2(cursor: cursor, close: shouldClose, input: fileChunkInputStream).response(queue: DispatchQueue(label: "testing"), completionHandler: { result, error in
-            if result == nil {
+
+        let chunkSent = {
+            upload.chunkIndex += 1
+            if upload.chunkIndex == upload.numberOfChunks {
+                self.finishLargeFileUpload(uploadData: uploadData, upload: upload)
+            } else {
+                self.uploadNextChunk(uploadData: uploadData, upload: upload)
+            }
+        }
+
+        if let sessionId = upload.sessionId {
+            let cursor = Files.UploadSessionCursor(sessionId: sessionId, offset: index * fileChunkSize)
+            self.uploadSessionAppendV2(cursor: cursor, close: shouldClose, input: data).response(queue: uploadData.stateQueue, completionHandler: { result, error in
                 if let error = error {
-                    switch error as CallError {
-                    case .rateLimitError(let rateLimitError, _, _, _):
-                        let backoffInSeconds = rateLimitError.retryAfter
-                        DispatchQueue.main.asyncAfter(deadline: .now() + Double(backoffInSeconds)) {
-                            if retryCount <= 3 {
-                                self.appendFileChunk(uploadData: uploadData, fileUrl: fileUrl, cursor: cursor, shouldClose: shouldClose, fileChunkInputStream: fileChunkInputStream, chunkUploadResponseQueue: chunkUploadResponseQueue, chunkUploadFinished: chunkUploadFinished, retryCount: retryCount + 1, startBytes: startBytes, endBytes: endBytes, shouldContinue: shouldContinue)
-                            } else {
-//                                uploadData.fileUrlsToRequestErrors[fileUrl] = error
-//                                shouldContinue = false
-                            }
-                        }
-                    default:
-                        print("hi")
-                    }
-                    //            uploadData.taskStorage.remove(task)
+                    retryOrFinish(self.chunkRetryDelay(error: error, retryCount: retryCount))
+                } else {
+                    chunkSent()
+                }
+            }).progress { progress in
+                if retryCount == 0 {
+                    self.executeProgressHandler(uploadData: uploadData, progress: progress)
                 }
             }
-            chunkUploadFinished.signal()
-        }) .progress { progress in
-            if retryCount == 0 {
-                self.executeProgressHandler(uploadData:uploadData, progress: progress)
+        } else {
+            self.uploadSessionStart(close: shouldClose, input: data).response(queue: uploadData.stateQueue, completionHandler: { result, error in
+                if let result = result {
+                    upload.sessionId = result.sessionId
+                    let cursor = Files.UploadSessionCursor(sessionId: result.sessionId, offset: upload.fileSize)
+                    let commitInfo = uploadData.fileUrlsToCommitInfo[upload.fileUrl]!
+                    let finishArg = Files.UploadSessionFinishArg(cursor: cursor, commit: commitInfo)
+                    // Store commit info for this file
+                    uploadData.finishArgs.append(finishArg)
+                    chunkSent()
+                } else {
+//                    uploadData.fileUrlsToRequestErrors[fileUrl] = error
+                    retryOrFinish(error.flatMap { self.chunkRetryDelay(error: $0, retryCount: retryCount) })
+                }
+            }).progress { progress in
+                if retryCount == 0 {
+                    self.executeProgressHandler(uploadData: uploadData, progress: progress)
+                }
             }
         }
+    }
 
-//        uploadData.taskStorage.add(task)
+    // nil if the error isn't worth retrying.
+    func chunkRetryDelay<EType>(error: CallError<EType>, retryCount: Int) -> Double? {
+        switch error {
+        case .rateLimitError(let rateLimitError, _, _, _):
+            return Double(rateLimitError.retryAfter)
+        case .clientError, .internalServerError:
+            return pow(2.0, Double(retryCount))
+        default:
+            return nil
+        }
     }
 
     func queryJobStatus(uploadData: BatchUploadData, asyncJobId: String, retryCount: Int) {
@@ -243,7 +269,9 @@ extension FilesRoutes {
         // wait for all upload calls to complete and then batch "finish" all uploaded files
         // with one call to `upload_session/finish_batch`
         uploadData.uploadGroup.notify(queue: DispatchQueue.main) {
-            uploadData.finishArgs.sort { $0.commit.path < $1.commit.path }
+            uploadData.stateQueue.sync {
+                uploadData.finishArgs.sort { $0.commit.path < $1.commit.path }
+            }
             
             self.uploadSessionFinishBatch(entries: uploadData.finishArgs).response { result, error in
                 if let result = result {
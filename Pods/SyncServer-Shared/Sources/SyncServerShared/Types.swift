@@ -23,6 +23,7 @@ public enum ServerHTTPMethod : String {
 
 public enum HTTPStatus : Int {
     case ok = 200
+    case partialContent = 206
     case unauthorized = 401
     case forbidden = 403
     case gone = 410
@@ -7,10 +7,88 @@
 //
 
 import Foundation
+import CoreData
 import SMCoreLib
 import SyncServer_Shared
 
 class Consistency {
+    // Caps the number of file UUIDs listed for each kind of problem, so the report stays readable with large albums. The counts are always complete.
+    static let maxFilesListedPerProblem = 10
+    
+    enum Problem: String, CaseIterable {
+        case deletedServerFileInLocalFiles = "Deleted server file *is* in local files"
+        
+        // Present in local meta data, but not present locally. (If the file was not present in local meta data and not present locally, a sync would have fixed this).
+        case serverFileNotInLocalFiles = "Server file not in local files"
+        
+        // We should have *every* entry in the local DirectoryEntry meta data also. These issues should never happen: Our sync should prevent these.
+        case serverFileNotInDirectoryEntries = "Server file not in DirectoryEntry meta data"
+        case serverFileDeletionInconsistent = "Server file and DirectoryEntry meta data have inconsistent deletion status"
+        
+        // All local files should be non-deleted on server
+        case localFileNotOnServer = "Local file not on server"
+        case localFileDeletedOnServer = "Local file deleted on server"
+        
+        // And those local files should *all* be in the local meta data.
+        case localFileNotInDirectoryEntries = "Local file not in DirectoryEntry meta data"
+        case localFileDeletedInDirectoryEntries = "Local file marked as deleted in DirectoryEntry meta data"
+    }
+    
+    struct Report {
+        let numberServerFiles: Int
+        let numberLocalFiles: Int
+        let numberDirectoryEntries: Int
+        
+        private(set) var counts = [Problem: Int]()
+        private(set) var files = [Problem: [UUIDString]]()
+        
+        // All of them, not limited like `files`; these are what repair fixes.
+        private(set) var serverFilesNotPresentLocally = [UUIDString]()
+        
+        init(numberServerFiles: Int, numberLocalFiles: Int, numberDirectoryEntries: Int) {
+            self.numberServerFiles = numberServerFiles
+            self.numberLocalFiles = numberLocalFiles
+            self.numberDirectoryEntries = numberDirectoryEntries
+        }
+        
+        var isConsistent: Bool {
+            return counts.isEmpty && numberDirectoryEntries == numberServerFiles
+        }
+        
+        mutating func add(_ problem: Problem, fileUUID: UUIDString) {
+            counts[problem, default: 0] += 1
+            if counts[problem]! <= Consistency.maxFilesListedPerProblem {
+                files[problem, default: []] += [fileUUID]
+            }
+            
+            if problem == .serverFileNotInLocalFiles {
+                serverFilesNotPresentLocally += [fileUUID]
+            }
+        }
+        
+        var message: String {
+            var message = "\nConsistency check: Results through \(numberLocalFiles) local files, \(numberServerFiles) server files, and \(numberDirectoryEntries) DirectoryEntry meta data entries:\n"
+            
+            for problem in Problem.allCases {
+                guard let count = counts[problem], let listed = files[problem] else {
+                    continue
+                }
+                
+                message += "\(problem.rawValue): \(count) file(s)"
+                if count > listed.count {
+                    message += ", including"
+                }
+                message += " \(listed.joined(separator: ", "))\n"
+            }
+            
+            if numberDirectoryEntries != numberServerFiles {
+                message += "DirectoryEntry meta data different size than on server: \(numberDirectoryEntries) versus \(numberServerFiles)\n"
+            }
+            
+            return message
+        }
+    }
+    
     static func check(sharingGroupUUID: String, localFiles:[UUIDString], repair:Bool = false, callback:((Error?)->())?) {
         ServerAPI.session.index(sharingGroupUUID: sharingGroupUUID) { response in
             var indexResult:ServerAPI.IndexResult!
@@ -27,85 +105,33 @@ class Consistency {
                 return
             }
             
-            var messageResult = ""
-
-            // Present in local meta data, but not present locally. (If the file was not present in local meta data and not present locally, a sync would have fixed this).
-            var serverFilesNotPresentLocally = [UUIDString]()
-            
-            // Present in local meta data, but not deleted.
-            // var deletedServerFilesButPresentLocally = [UUIDString]()
-
-            // First, check server files.
-            for file in fileInfo {
-                // Check against local files.
-                if file.deleted! {
-                    if localFiles.contains(file.fileUUID) {
-                        messageResult += "Deleted Server file: \(file.fileUUID!) *is* in local files\n"
-                    }
-                }
-                else {
-                    if !localFiles.contains(file.fileUUID!) {
-                        serverFilesNotPresentLocally += [file.fileUUID!]
-                        messageResult += "Server file: \(file.fileUUID!) not in local files \(localFiles)\n"
-                    }
+            var fetchError: Error?
+            var entries = [UUIDString: Bool]()
+            CoreDataSync.perform(sessionName: Constants.coreDataName) {
+                do {
+                    entries = try Consistency.directoryEntryDeletions(sharingGroupUUID: sharingGroupUUID)
+                } catch (let error) {
+                    fetchError = error
                 }
+            }
                 
-                CoreDataSync.perform(sessionName: Constants.coreDataName) {
-                    // We should have *every* entry in the local DirectoryEntry meta data also. These issues should never happen: Our sync should prevent these.
-                    let entry = DirectoryEntry.fetchObjectWithUUID(uuid: file.fileUUID)
-                    if entry == nil {
-                        messageResult += "Server file: \(file.fileUUID!) not in DirectoryEntry meta data\n"
-                    }
-                    else if entry!.deletedLocally != file.deleted {
-                        messageResult += "Server file: \(file.fileUUID!) and DirectoryEntry meta data have inconsistent deletion status: \(file.deleted!) versus \(entry!.deletedLocally)\n"
-                    }
-                }
+            if let fetchError = fetchError {
+                callback?(fetchError)
+                return
             }
             
-            for localFile in localFiles {
-                // All local files should be non-deleted on server
-                let result = fileInfo.filter {$0.fileUUID == localFile}
-                if result.count == 0 {
-                    messageResult += "Local file: \(localFile) not on server\n"
-                }
-                else if result[0].deleted! {
-                    messageResult += "Local file: \(localFile) deleted on server\n"
-                }
+            let report = compare(serverFiles: fileInfo, localFiles: localFiles, directoryEntryDeletions: entries)
                 
-                CoreDataSync.perform(sessionName: Constants.coreDataName) {
-                    // And those local files should *all* be in the local meta data.
-                    let entry = DirectoryEntry.fetchObjectWithUUID(uuid: localFile)
-                    if entry == nil {
-                        messageResult += "Local file: \(localFile) not in DirectoryEntry meta data\n"
-                    }
-                    else if entry!.deletedLocally {
-                        messageResult += "Local file: \(localFile) marked as deleted in DirectoryEntry meta data\n"
-                    }
-                }
-            }
-
-            var entries:[DirectoryEntry]!
-
-            CoreDataSync.perform(sessionName: Constants.coreDataName) {
-                // All the local data should be on the server.
-                entries = DirectoryEntry.fetchAll()
-                if entries.count != fileInfo.count {
-                    messageResult += "DirectoryEntry meta data different size than on server: \(entries.count) versus \(fileInfo.count)\n"
-                }
-            }
-
-            if messageResult.count > 0 {
-                messageResult = "\nConsistency check: Results through \(localFiles.count) local files, \(fileInfo.count) server files, and \(entries.count) DirectoryEntry meta data entries:\n\(messageResult)"
-                Log.warning(messageResult)
+            if report.isConsistent {
+                Log.info("Consistency check: OK!")
             }
             else {
-                messageResult = "Consistency check: OK!"
-                Log.info(messageResult)
+                Log.warning(report.message)
             }
             
             if repair {
                 do {
-                    try repairServerFilesNotPresentLocally(fileUUIDs: serverFilesNotPresentLocally, sharingGroupUUID: sharingGroupUUID) {
+                    try repairServerFilesNotPresentLocally(fileUUIDs: report.serverFilesNotPresentLocally, sharingGroupUUID: sharingGroupUUID) {
                         callback?(nil)
                     }
                 } catch (let error) {
@@ -118,9 +144,89 @@ class Consistency {
         }
     }
     
+    // Three way comparison between the server index, the local files, and the DirectoryEntry meta data (file UUID -> deletedLocally). Linear in the total number of files.
+    static func compare(serverFiles: [FileInfo], localFiles: [UUIDString], directoryEntryDeletions entries: [UUIDString: Bool]) -> Report {
+        var report = Report(numberServerFiles: serverFiles.count, numberLocalFiles: localFiles.count, numberDirectoryEntries: entries.count)
+        
+        let localFileSet = Set(localFiles)
+        
+        // File UUID -> deleted on server.
+        var serverDeletions = [UUIDString: Bool](minimumCapacity: serverFiles.count)
+        
+        for file in serverFiles {
+            guard let fileUUID = file.fileUUID else {
+                continue
+            }
+            
+            let deleted = file.deleted ?? false
+            serverDeletions[fileUUID] = deleted
+            
+            // Check against local files.
+            if deleted {
+                if localFileSet.contains(fileUUID) {
+                    report.add(.deletedServerFileInLocalFiles, fileUUID: fileUUID)
+                }
+            }
+            else if !localFileSet.contains(fileUUID) {
+                report.add(.serverFileNotInLocalFiles, fileUUID: fileUUID)
+            }
+            
+            if let deletedLocally = entries[fileUUID] {
+                if deletedLocally != deleted {
+                    report.add(.serverFileDeletionInconsistent, fileUUID: fileUUID)
+                }
+            }
+            else {
+                report.add(.serverFileNotInDirectoryEntries, fileUUID: fileUUID)
+            }
+        }
+        
+        for localFile in localFiles {
+            if let deleted = serverDeletions[localFile] {
+                if deleted {
+                    report.add(.localFileDeletedOnServer, fileUUID: localFile)
+                }
+            }
+            else {
+                report.add(.localFileNotOnServer, fileUUID: localFile)
+            }
+            
+            if let deletedLocally = entries[localFile] {
+                if deletedLocally {
+                    report.add(.localFileDeletedInDirectoryEntries, fileUUID: localFile)
+                }
+            }
+            else {
+                report.add(.localFileNotInDirectoryEntries, fileUUID: localFile)
+            }
+        }
+        
+        return report
+    }
+    
+    // One fetch for the whole sharing group, of just the two attributes needed, rather than a fetch per file. Call within CoreDataSync.perform.
+    static func directoryEntryDeletions(sharingGroupUUID: String) throws -> [UUIDString: Bool] {
+        let request = NSFetchRequest<NSDictionary>(entityName: DirectoryEntry.entityName())
+        request.predicate = NSPredicate(format: "sharingGroupUUID == %@", sharingGroupUUID)
+        request.resultType = .dictionaryResultType
+        request.propertiesToFetch = [DirectoryEntry.UUID_KEY, DirectoryEntry.DELETED_LOCALLY_KEY]
+        
+        let rows = try CoreData.sessionNamed(Constants.coreDataName).context.fetch(request)
+        
+        var result = [UUIDString: Bool](minimumCapacity: rows.count)
+        for row in rows {
+            if let fileUUID = row[DirectoryEntry.UUID_KEY] as? UUIDString {
+                result[fileUUID] = (row[DirectoryEntry.DELETED_LOCALLY_KEY] as? Bool) ?? false
+            }
+        }
+        
+        return result
+    }
+    
     static func repairServerFilesNotPresentLocally(fileUUIDs:[UUIDString], sharingGroupUUID: String, completion:@escaping ()->()) throws {
         if fileUUIDs.count == 0 {
             completion()
+            return
         }
         
         var resultError: Error?
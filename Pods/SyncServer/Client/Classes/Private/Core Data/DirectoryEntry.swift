@@ -17,6 +17,9 @@ public class DirectoryEntry: NSManagedObject, CoreDataModel, AllOperations {
 
     public static let UUID_KEY = "fileUUID"
     
+    // For fetches of just some attributes, e.g., with a dictionary result type.
+    public static let DELETED_LOCALLY_KEY = "deletedLocallyInternal"
+    
     // File's don't get updated with their version until an upload or download occurs. This means that when a DirectoryEntry is created for an upload of a new file, the fileVersion is initially nil.
     public var fileVersion:FileVersionInt? {
         get {
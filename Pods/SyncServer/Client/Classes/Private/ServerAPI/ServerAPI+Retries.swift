@@ -16,9 +16,219 @@ import Foundation
 import SMCoreLib
 import SyncServer_Shared
 
+// Shared by all requests, so that when the server has problems, queued uploads, downloads and index requests don't all retry in lockstep and pile more load onto it.
+// 1) Delays use "decorrelated jitter": each is random between `baseDelay` and three times the request's previous delay, capped at `maximumDelay`.
+// 2) Each endpoint has a token bucket retry budget. A retry takes a token; tokens come back slowly over time. With the bucket empty, requests to that endpoint fail rather than retry.
+// 3) A Retry-After from the server holds off retries to that endpoint until then.
+// 4) A circuit breaker opens after `failureThreshold` consecutive failures across all endpoints. While it's open, nothing is retried. After `openDuration` it lets one retry through ("half open"); if that works, it closes again.
+// Only retries are limited here. First attempts always go to the server.
+class RetryScheduler {
+    // Requests use the scheduler that's here when they start. Tests replace it with one that has shorter delays.
+    static var session = RetryScheduler()
+    
+    enum CircuitState {
+        case closed
+        case open(until: Date)
+        case halfOpen
+    }
+    
+    let baseDelay: TimeInterval
+    let maximumDelay: TimeInterval
+    
+    // A Retry-After longer than this means we don't retry at all.
+    let maximumRetryAfter: TimeInterval = 5 * 60
+    
+    let budgetCapacity: Double = 10
+    
+    // Tokens per second.
+    let budgetRefillRate: Double = 0.1
+    
+    let failureThreshold = 5
+    let openDuration: TimeInterval
+    
+    private struct Budget {
+        var tokens: Double
+        var lastRefill: Date
+        var notBefore: Date?
+    }
+    
+    private var budgets = [String: Budget]()
+    private(set) var circuitState: CircuitState = .closed
+    private var consecutiveFailures = 0
+    
+    private let now: ()->Date
+    private let random: (ClosedRange<Double>)->Double
+    
+    init(baseDelay: TimeInterval = 1, maximumDelay: TimeInterval = 60, openDuration: TimeInterval = 30, now: @escaping ()->Date = { Date() }, random: @escaping (ClosedRange<Double>)->Double = { Double.random(in: $0) }) {
+        self.baseDelay = baseDelay
+        self.maximumDelay = maximumDelay
+        self.openDuration = openDuration
+        self.now = now
+        self.random = random
+    }
+    
+    // Requests are grouped by endpoint, i.e., the URL path; the parameters don't matter.
+    static func endpoint(for serverURL: URL) -> String {
+        return serverURL.path
+    }
+    
+    func recordSuccess() {
+        Synchronized.block(self) {
+            consecutiveFailures = 0
+            if case .closed = circuitState {
+                return
+            }
+            
+            Log.msg("RetryScheduler: Closing circuit breaker")
+            circuitState = .closed
+        }
+    }
+    
+    func recordFailure() {
+        Synchronized.block(self) {
+            consecutiveFailures += 1
+            
+            switch circuitState {
+            case .closed:
+                if consecutiveFailures >= failureThreshold {
+                    open()
+                }
+            case .halfOpen:
+                // The trial retry failed.
+                open()
+            case .open:
+                break
+            }
+        }
+    }
+    
+    // The outcome of a request: `succeeded` is true when there was no error.
+    // A 401 counts as a success: the server is up and responding; it's our credentials that are the problem. Without this, a trial retry that got a 401 would leave the breaker half open, and nothing would be retried again.
+    func record(statusCode: Int?, succeeded: Bool) {
+        if succeeded || statusCode == HTTPStatus.unauthorized.rawValue {
+            recordSuccess()
+        }
+        else {
+            recordFailure()
+        }
+    }
+    
+    // Must be called within Synchronized.block.
+    private func open() {
+        Log.warning("RetryScheduler: Opening circuit breaker for \(openDuration)s after \(consecutiveFailures) failures")
+        circuitState = .open(until: now().addingTimeInterval(openDuration))
+    }
+    
+    // Returns the delay before retrying, or nil if the request shouldn't be retried. `previousDelay` is the delay before this request's last retry, or nil if this is its first.
+    func retryDelay(endpoint: String, previousDelay: TimeInterval?, retryAfter: TimeInterval? = nil) -> TimeInterval? {
+        var result: TimeInterval?
+        
+        Synchronized.block(self) {
+            let currentTime = now()
+            
+            if let retryAfter = retryAfter {
+                guard retryAfter <= maximumRetryAfter else {
+                    Log.warning("RetryScheduler: Retry-After too long: \(retryAfter)s for \(endpoint)")
+                    return
+                }
+                
+                var budget = refilledBudget(endpoint: endpoint, at: currentTime)
+                let notBefore = currentTime.addingTimeInterval(retryAfter)
+                budget.notBefore = max(budget.notBefore ?? notBefore, notBefore)
+                budgets[endpoint] = budget
+            }
+            
+            var trial = false
+            switch circuitState {
+            case .closed:
+                break
+            case .open(let until):
+                guard currentTime >= until else {
+                    Log.warning("RetryScheduler: Circuit breaker open; not retrying \(endpoint)")
+                    return
+                }
+                trial = true
+            case .halfOpen:
+                Log.warning("RetryScheduler: Circuit breaker half open; not retrying \(endpoint)")
+                return
+            }
+            
+            var budget = refilledBudget(endpoint: endpoint, at: currentTime)
+            guard budget.tokens >= 1 else {
+                Log.warning("RetryScheduler: Retry budget exhausted for \(endpoint)")
+                budgets[endpoint] = budget
+                return
+            }
+            
+            if trial {
+                // Let this one through; others wait for its outcome.
+                circuitState = .halfOpen
+            }
+            
+            budget.tokens -= 1
+            budgets[endpoint] = budget
+            
+            var delay = RetryScheduler.decorrelatedJitter(previousDelay: previousDelay, base: baseDelay, maximum: maximumDelay, random: random)
+            if let notBefore = budget.notBefore {
+                delay = max(delay, notBefore.timeIntervalSince(currentTime))
+            }
+            
+            result = delay
+        }
+        
+        return result
+    }
+    
+    // Must be called within Synchronized.block.
+    private func refilledBudget(endpoint: String, at currentTime: Date) -> Budget {
+        guard var budget = budgets[endpoint] else {
+            return Budget(tokens: budgetCapacity, lastRefill: currentTime, notBefore: nil)
+        }
+        
+        let elapsed = max(currentTime.timeIntervalSince(budget.lastRefill), 0)
+        budget.tokens = min(budgetCapacity, budget.tokens + elapsed * budgetRefillRate)
+        budget.lastRefill = currentTime
+        
+        if let notBefore = budget.notBefore, notBefore <= currentTime {
+            budget.notBefore = nil
+        }
+        
+        return budget
+    }
+    
+    static func decorrelatedJitter(previousDelay: TimeInterval?, base: TimeInterval, maximum: TimeInterval, random: (ClosedRange<Double>)->Double) -> TimeInterval {
+        let upper = max(base, (previousDelay ?? base) * 3)
+        return min(maximum, random(base...upper))
+    }
+    
+    // Retry-After is either a number of seconds or an HTTP date.
+    static func retryAfter(response: HTTPURLResponse?, now: Date = Date()) -> TimeInterval? {
+        guard let value = response?.allHeaderFields["Retry-After"] as? String else {
+            return nil
+        }
+        
+        let trimmed = value.trimmingCharacters(in: .whitespaces)
+        if let seconds = TimeInterval(trimmed) {
+            return max(seconds, 0)
+        }
+        
+        let formatter = DateFormatter()
+        formatter.locale = Locale(identifier: "en_US_POSIX")
+        formatter.timeZone = TimeZone(abbreviation: "GMT")
+        formatter.dateFormat = "EEE, dd MMM yyyy HH:mm:ss zzz"
+        if let date = formatter.date(from: trimmed) {
+            return max(date.timeIntervalSince(now), 0)
+        }
+        
+        return nil
+    }
+}
+
 private class RequestWithRetries {
     let maximumNumberRetries = 3
     
+    let endpoint:String
+    let scheduler = RetryScheduler.session
     let creds:GenericCredentials?
     let updateCreds:((_ creds:GenericCredentials?)->())
     let checkForError:(_ statusCode:Int?, _ error:SyncServerError?) -> SyncServerError?
@@ -28,6 +238,7 @@ private class RequestWithRetries {
     private var triedToRefreshCreds = false
     private var numberTries = 0
     private var retryIfError:Bool
+    private var previousDelay:TimeInterval?
 
     var request:(()->())!
     var completionHandler:((_ error:SyncServerError?)->())!
@@ -35,7 +246,8 @@ private class RequestWithRetries {
     // When we get a 401 response from server.
     var userUnauthorized:(()->())!
     
-    init(retryIfError:Bool = true, creds:GenericCredentials?, desiredEvents:EventDesired, delegate:SyncServerDelegate?, updateCreds:@escaping (_ creds:GenericCredentials?)->(), checkForError:@escaping (_ statusCode:Int?, _ error:SyncServerError?) -> SyncServerError?, userUnauthorized:@escaping ()->()) {
+    init(serverURL: URL, retryIfError:Bool = true, creds:GenericCredentials?, desiredEvents:EventDesired, delegate:SyncServerDelegate?, updateCreds:@escaping (_ creds:GenericCredentials?)->(), checkForError:@escaping (_ statusCode:Int?, _ error:SyncServerError?) -> SyncServerError?, userUnauthorized:@escaping ()->()) {
+        self.endpoint = RetryScheduler.endpoint(for: serverURL)
         self.creds = creds
         self.updateCreds = updateCreds
         self.checkForError = checkForError
@@ -65,19 +277,20 @@ private class RequestWithRetries {
         }
     }
     
-    // Returns a duration in seconds.
-    func exponentialFallbackDuration(forAttempt numberTimesTried:Int) -> TimeInterval {
-        let duration = TimeInterval(pow(Float(numberTimesTried), 2.0))
+    // Returns false, without calling the completion, if the scheduler says not to retry.
+    func fallback(retryAfter:TimeInterval?, completion:@escaping ()->()) -> Bool {
+        guard let duration = scheduler.retryDelay(endpoint: endpoint, previousDelay: previousDelay, retryAfter: retryAfter) else {
+            return false
+        }
+        
+        previousDelay = duration
         Log.msg("Will try operation again in \(duration) seconds")
-        return duration
-    }
-
-    func exponentialFallback(forAttempt numberTimesTried:Int, completion:@escaping ()->()) {
-        let duration = exponentialFallbackDuration(forAttempt: numberTimesTried)
 
         TimedCallback.withDuration(Float(duration)) {
             completion()
         }
+        
+        return true
     }
     
     private func completion(_ error:SyncServerError?) {
@@ -88,10 +301,12 @@ private class RequestWithRetries {
         request = nil
     }
 
-    func retryCheck(statusCode:Int?, error:SyncServerError?) {
+    func retryCheck(statusCode:Int?, error:SyncServerError?, response:HTTPURLResponse?) {
         numberTries += 1
         let errorCheck = checkForError(statusCode, error)
         
+        scheduler.record(statusCode: statusCode, succeeded: errorCheck == nil)
+        
         // Do not do a retry on serviceUnavailable. Not much point. Plus, if we do retries in this case, we'll get multiple errror messages.
         if errorCheck == nil || numberTries >= maximumNumberRetries ||
             !retryIfError || statusCode == HTTPStatus.serviceUnavailable.rawValue {
@@ -124,10 +339,14 @@ private class RequestWithRetries {
             Log.error("errorCheck: \(String(describing: errorCheck)); statusCode: \(String(describing: statusCode))")
             
             // We got an error, but it wasn't an authorization problem.
-            // Let's make another try after waiting for a while.
-            exponentialFallback(forAttempt: numberTries) {
+            // Let's make another try after waiting for a while-- if the retry scheduler thinks the server can take it.
+            let retrying = fallback(retryAfter: RetryScheduler.retryAfter(response: response)) {
                 self.start()
             }
+            
+            if !retrying {
+                completion(errorCheck)
+            }
         }
     }
     
@@ -144,11 +363,11 @@ extension ServerAPI {
     
     func sendRequestUsing(method: ServerHTTPMethod, toURL serverURL: URL, timeoutIntervalForRequest:TimeInterval = ServerNetworking.defaultTimeout, retryIfError retry:Bool=true, completion:((_ serverResponse:[String:Any]?, _ statusCode:Int?, _ error:SyncServerError?)->())?) {
         
-        let rwr = RequestWithRetries(retryIfError: retry, creds:creds, desiredEvents:desiredEvents, delegate:syncServerDelegate, updateCreds: updateCreds, checkForError:checkForError, userUnauthorized: userUnauthorized)
+        let rwr = RequestWithRetries(serverURL: serverURL, retryIfError: retry, creds:creds, desiredEvents:desiredEvents, delegate:syncServerDelegate, updateCreds: updateCreds, checkForError:checkForError, userUnauthorized: userUnauthorized)
         
         // I get rid of the circular references in the completion handler. These references are being used to retain the rwr object.
         rwr.request = {
-            ServerNetworking.session.sendRequestUsing(method: method, toURL: serverURL, timeoutIntervalForRequest:timeoutIntervalForRequest) { (serverResponse, statusCode, error) in
+            ServerNetworking.session.sendRequestUsing(method: method, toURL: serverURL, timeoutIntervalForRequest:timeoutIntervalForRequest) { (serverResponse, statusCode, error, urlResponse) in
                 
                 rwr.completionHandler = { error in
                     completion?(serverResponse, statusCode, error)
@@ -160,7 +379,7 @@ extension ServerAPI {
                 let theStatusCode:Int? = statusCode
 #endif
 
-                rwr.retryCheck(statusCode: theStatusCode, error: error)
+                rwr.retryCheck(statusCode: theStatusCode, error: error, response: urlResponse)
             }
         }
         rwr.start()
@@ -168,7 +387,7 @@ extension ServerAPI {
     
     func upload(file: ServerNetworkingLoadingFile, fromLocalURL localURL: URL, toServerURL serverURL: URL, method: ServerHTTPMethod, completion:((_ urlResponse: HTTPURLResponse?, _ uploadResponseBody: [String: Any]?, _ statusCode:Int?, _ error:SyncServerError?)->())?) {
         
-        let rwr = RequestWithRetries(creds:creds, desiredEvents:desiredEvents, delegate:syncServerDelegate, updateCreds: updateCreds, checkForError:checkForError, userUnauthorized: userUnauthorized)
+        let rwr = RequestWithRetries(serverURL: serverURL, creds:creds, desiredEvents:desiredEvents, delegate:syncServerDelegate, updateCreds: updateCreds, checkForError:checkForError, userUnauthorized: userUnauthorized)
         
         // I get rid of the circular references in the completion handler. These references are being used to retain the rwr object.
         rwr.request = {
@@ -177,7 +396,7 @@ extension ServerAPI {
                 rwr.completionHandler = { error in
                     completion?(serverResponse, uploadResponseBody, statusCode, error)
                 }
-                rwr.retryCheck(statusCode: statusCode, error: error)
+                rwr.retryCheck(statusCode: statusCode, error: error, response: serverResponse)
             }
         }
         rwr.start()
@@ -185,7 +404,7 @@ extension ServerAPI {
     
     func download(file: ServerNetworkingLoadingFile, fromServerURL serverURL: URL, method: ServerHTTPMethod, completion:((SMRelativeLocalURL?, _ urlResponse:HTTPURLResponse?, _ statusCode:Int?, _ error:SyncServerError?)->())?) {
         
-        let rwr = RequestWithRetries(creds:creds, desiredEvents:desiredEvents, delegate:syncServerDelegate, updateCreds: updateCreds, checkForError:checkForError, userUnauthorized: userUnauthorized)
+        let rwr = RequestWithRetries(serverURL: serverURL, creds:creds, desiredEvents:desiredEvents, delegate:syncServerDelegate, updateCreds: updateCreds, checkForError:checkForError, userUnauthorized: userUnauthorized)
         
         // I get rid of the circular references in the completion handler. These references are being used to retain the rwr object.
         rwr.request = {
@@ -194,7 +413,7 @@ extension ServerAPI {
                 rwr.completionHandler = { error in
                     completion?(localURL, urlResponse, statusCode, error)
                 }
-                rwr.retryCheck(statusCode: statusCode, error: error)
+                rwr.retryCheck(statusCode: statusCode, error: error, response: urlResponse)
             }
         }
         rwr.start()
@@ -29,6 +29,69 @@ struct ServerNetworkingLoadingFile {
     let fileVersion: FileVersionInt
 }
 
+// When a download fails part way through (e.g., a flaky network), URLSession can give us resume data: it records how much of the file we have, and lets a new task continue with an HTTP Range request rather than starting again from byte zero. This keeps that data on disk, one file per file version, so the next attempt at the same download-- from RequestWithRetries, or after the app is relaunched-- can pick up where the last one left off. If the server doesn't support ranges for a download, URLSession doesn't give resume data, and the download starts from scratch as before.
+class DownloadResumeData {
+    static let session = DownloadResumeData()
+    
+    // Resume data replays the auth headers of the original request. Past the lifetime of an access token (an hour for Google) those are stale, and resuming would just get a 401.
+    static let maximumAge: TimeInterval = 60 * 60
+    
+    private let directory: URL
+    private let maximumAge: TimeInterval
+    
+    init(directory: URL = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask)[0].appendingPathComponent("SyncServer.DownloadResumeData"), maximumAge: TimeInterval = DownloadResumeData.maximumAge) {
+        self.directory = directory
+        self.maximumAge = maximumAge
+        try? FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true, attributes: nil)
+    }
+    
+    private func url(for file: ServerNetworkingLoadingFile) -> URL {
+        return directory.appendingPathComponent("\(file.fileUUID).\(file.fileVersion)")
+    }
+    
+    func save(_ resumeData: Data, for file: ServerNetworkingLoadingFile) {
+        do {
+            try resumeData.write(to: url(for: file), options: .atomic)
+        } catch (let error) {
+            Log.error("Could not save resume data: \(error)")
+        }
+    }
+    
+    // Resume data can only be used once, so this removes it. Returns nil if the resume data is too old to use.
+    func take(for file: ServerNetworkingLoadingFile) -> Data? {
+        let fileURL = url(for: file)
+        guard let resumeData = try? Data(contentsOf: fileURL) else {
+            return nil
+        }
+        
+        let old = isOld(fileURL)
+        remove(for: file)
+        return old ? nil : resumeData
+    }
+    
+    func remove(for file: ServerNetworkingLoadingFile) {
+        try? FileManager.default.removeItem(at: url(for: file))
+    }
+    
+    func removeOld() {
+        guard let urls = try? FileManager.default.contentsOfDirectory(at: directory, includingPropertiesForKeys: [.contentModificationDateKey], options: []) else {
+            return
+        }
+        
+        for fileURL in urls where isOld(fileURL) {
+            try? FileManager.default.removeItem(at: fileURL)
+        }
+    }
+    
+    private func isOld(_ fileURL: URL) -> Bool {
+        guard let modified = (try? fileURL.resourceValues(forKeys: [.contentModificationDateKey]))?.contentModificationDate else {
+            return false
+        }
+        
+        return modified < Date(timeIntervalSinceNow: -maximumAge)
+    }
+}
+
 class ServerNetworkingLoading : NSObject {
     static private(set) var session = ServerNetworkingLoading()
     
@@ -39,6 +102,12 @@ class ServerNetworkingLoading : NSObject {
     fileprivate var backgroundCompletionHandler:(()->())?
     
     fileprivate var uploadBodyResults = [URLSessionUploadTask: [String: Any]]()
+    
+    // So we know which file version to keep resume data for if a download fails.
+    fileprivate var downloadFiles = [URLSessionTask: ServerNetworkingLoadingFile]()
+    
+    // Downloads started from resume data; these finish with a 206 rather than a 200.
+    fileprivate var resumedTasks = Set<URLSessionTask>()
 
     private override init() {
         super.init()
@@ -48,6 +117,8 @@ class ServerNetworkingLoading : NSObject {
         CoreDataSync.perform(sessionName: Constants.coreDataName) {
             NetworkCached.deleteOldCacheEntries()
         }
+        
+        DownloadResumeData.session.removeOld()
     }
     
     private func createURLSession() {
@@ -79,7 +150,20 @@ class ServerNetworkingLoading : NSObject {
     }
     
     // The caller must keep a strong reference to the returned object until at least all of the relevant ServerNetworkingDownloadDelegate delegate methods have been called upon completion of the download.
-    private func downloadFrom(_ serverURL: URL, method: ServerHTTPMethod, andStart start:Bool=true) -> URLSessionDownloadTask {
+    // With `resumeData`, the download continues from where a previous one for the same file version left off. The resume data carries the original request, headers included.
+    private func downloadFrom(_ serverURL: URL, method: ServerHTTPMethod, resumeData: Data? = nil, andStart start:Bool=true) -> URLSessionDownloadTask {
+        if let resumeData = resumeData {
+            Log.msg("downloadFrom: resuming: serverURL: \(serverURL)")
+            
+            let downloadTask = session.downloadTask(withResumeData: resumeData)
+            
+            if start {
+                downloadTask.resume()
+            }
+            
+            return downloadTask
+        }
+        
         var request = URLRequest(url: serverURL)
         request.httpMethod = method.rawValue.uppercased()
         
@@ -193,6 +277,25 @@ class ServerNetworkingLoading : NSObject {
         return result
     }
     
+    // Falls back to the cache when the task was started before the app was last launched.
+    fileprivate func downloadFile(task: URLSessionTask) -> ServerNetworkingLoadingFile? {
+        var file:ServerNetworkingLoadingFile?
+        Synchronized.block(self) {
+            file = downloadFiles[task]
+        }
+        
+        if file == nil, let serverURLKey = task.originalRequest?.url {
+            CoreDataSync.perform(sessionName: Constants.coreDataName) {
+                if let cache = NetworkCached.fetchObjectWithServerURLKey(serverURLKey.absoluteString),
+                    let fileUUID = cache.fileUUID {
+                    file = ServerNetworkingLoadingFile(fileUUID: fileUUID, fileVersion: cache.fileVersion)
+                }
+            }
+        }
+        
+        return file
+    }
+    
     fileprivate func removeCache(serverURLKey: URL) {
         CoreDataSync.perform(sessionName: Constants.coreDataName) {
             guard let cache = NetworkCached.fetchObjectWithServerURLKey(serverURLKey.absoluteString) else {
@@ -223,13 +326,27 @@ class ServerNetworkingLoading : NSObject {
         
         makeCache(file: file, serverURL: serverURL)
         
-        let task = downloadFrom(serverURL, method: method, andStart:false)
+        let resumeData = DownloadResumeData.session.take(for: file)
+        let task = downloadFrom(serverURL, method: method, resumeData: resumeData, andStart:false)
         Synchronized.block(self) {
             completionHandlers[task] = .download(completion)
+            downloadFiles[task] = file
+            if resumeData != nil {
+                resumedTasks.insert(task)
+            }
         }
         task.resume()
     }
     
+    // A resumed download gets the rest of the file as a 206 (Partial Content), and URLSession joins that onto the bytes we already had. So for the caller, that's the whole file, as with a 200.
+    static func downloadResponse(_ response: HTTPURLResponse?, resumed: Bool) -> HTTPURLResponse? {
+        guard resumed, let response = response, response.statusCode == HTTPStatus.partialContent.rawValue, let url = response.url else {
+            return response
+        }
+        
+        return HTTPURLResponse(url: url, statusCode: HTTPStatus.ok.rawValue, httpVersion: nil, headerFields: response.allHeaderFields as? [String: String]) ?? response
+    }
+    
     func upload(file:ServerNetworkingLoadingFile, fromLocalURL localURL: URL, toServerURL serverURL: URL, method: ServerHTTPMethod, completion:@escaping UploadCompletion) {
     
         // Before we go any further-- check to see if we have cached results.
@@ -303,14 +420,21 @@ extension ServerNetworkingLoading : URLSessionDelegate, URLSessionTaskDelegate,
         }
         
         // With an HTTP or HTTPS request, we get HTTPURLResponse back. See https://developer.apple.com/reference/foundation/urlsession/1407613-datatask
-        let response = downloadTask.response as? HTTPURLResponse
+        var handler:CompletionHandler?
+        var resumed = false
+        Synchronized.block(self) {
+            handler = completionHandlers[downloadTask]
+            resumed = resumedTasks.contains(downloadTask)
+        }
+        
+        let response = ServerNetworkingLoading.downloadResponse(downloadTask.response as? HTTPURLResponse, resumed: resumed)
         if response == nil {
             returnError = .couldNotGetHTTPURLResponse
         }
         
-        var handler:CompletionHandler?
-        Synchronized.block(self) {
-            handler = completionHandlers[downloadTask]
+        // Our credentials were out of date. Any resume data has the same stale auth headers, so don't use it when trying again with refreshed credentials.
+        if response?.statusCode == HTTPStatus.unauthorized.rawValue, let file = downloadFile(task: downloadTask) {
+            DownloadResumeData.session.remove(for: file)
         }
         
         if case .download(let completion)? = handler {
@@ -348,10 +472,17 @@ extension ServerNetworkingLoading : URLSessionDelegate, URLSessionTaskDelegate,
         let response = task.response as? HTTPURLResponse
         Log.msg("didCompleteWithError: \(String(describing: error)); status: \(String(describing: response?.statusCode))")
         
+        // Look this up before removing the cache object below; it may be the only record of the file.
+        if let error = error, task is URLSessionDownloadTask {
+            saveResumeData(task: task, error: error)
+        }
+        
         var handler:CompletionHandler?
         Synchronized.block(self) {
             handler = completionHandlers[task]
             completionHandlers[task] = nil
+            downloadFiles[task] = nil
+            resumedTasks.remove(task)
         }
         
         Log.msg("Number of completion handlers remaining in dictionary: \(completionHandlers.count)")
@@ -412,6 +543,21 @@ extension ServerNetworkingLoading : URLSessionDelegate, URLSessionTaskDelegate,
         }
     }
     
+    private func saveResumeData(task: URLSessionTask, error: Error) {
+        guard let file = downloadFile(task: task) else {
+            return
+        }
+        
+        // Not all errors give resume data; e.g., if the server doesn't support Range requests or the download was cancelled without producing it.
+        guard let resumeData = (error as NSError).userInfo[NSURLSessionDownloadTaskResumeData] as? Data else {
+            DownloadResumeData.session.remove(for: file)
+            return
+        }
+        
+        Log.msg("Saving resume data: uuid: \(file.fileUUID); version: \(file.fileVersion); bytes received: \(task.countOfBytesReceived)")
+        DownloadResumeData.session.save(resumeData, for: file)
+    }
+    
     // Apparently the following delegate method is how we get back body data from an upload task: "When the upload phase of the request finishes, the task behaves like a data task, calling methods on the session delegate to provide you with the server’s response—headers, status code, content data, and so on." (see https://developer.apple.com/documentation/foundation/nsurlsessionuploadtask).
     // But, how do we coordinate the status code and error info, apparently received in didCompleteWithError, with this??
     // 1/2/18; Because of this issue I've just now changed how the server upload response gives it's results-- the values now come back in an HTTP header key, just like the download.
@@ -26,6 +26,9 @@ class ServerNetworking : NSObject {
     static let session = ServerNetworking()
     var minimumServerVersion:ServerVersion?
     weak var syncServerDelegate:SyncServerDelegate?
+    
+    // Each request's session is configured from a copy of this. Tests set its `protocolClasses` to stand in for the server.
+    var sessionConfiguration = URLSessionConfiguration.default
     private weak var _delegate:ServerNetworkingDelegate?
     private var haveCellularData: Bool?
     private let cellState = CTCellularData.init()
@@ -60,10 +63,10 @@ class ServerNetworking : NSObject {
     }
     
     func sendRequestUsing(method: ServerHTTPMethod, toURL serverURL: URL, timeoutIntervalForRequest:TimeInterval = ServerNetworking.defaultTimeout,
-        completion:((_ serverResponse:[String:Any]?, _ statusCode:Int?, _ error:SyncServerError?)->())?) {
+        completion:((_ serverResponse:[String:Any]?, _ statusCode:Int?, _ error:SyncServerError?, _ urlResponse:HTTPURLResponse?)->())?) {
         
-        sendRequestTo(serverURL, method: method, timeoutIntervalForRequest:timeoutIntervalForRequest) { (serverResponse, statusCode, error) in
-            completion?(serverResponse, statusCode, error)
+        sendRequestTo(serverURL, method: method, timeoutIntervalForRequest:timeoutIntervalForRequest) { (serverResponse, statusCode, error, urlResponse) in
+            completion?(serverResponse, statusCode, error, urlResponse)
         }
     }
 
@@ -135,9 +138,9 @@ class ServerNetworking : NSObject {
         }
     }
     
-    private func sendRequestTo(_ serverURL: URL, method: ServerHTTPMethod, dataToUpload:Data? = nil, timeoutIntervalForRequest:TimeInterval, completion:((_ serverResponse:[String:Any]?, _ statusCode:Int?, _ error:SyncServerError?)->())?) {
+    private func sendRequestTo(_ serverURL: URL, method: ServerHTTPMethod, dataToUpload:Data? = nil, timeoutIntervalForRequest:TimeInterval, completion:((_ serverResponse:[String:Any]?, _ statusCode:Int?, _ error:SyncServerError?, _ urlResponse:HTTPURLResponse?)->())?) {
     
-        let sessionConfiguration = URLSessionConfiguration.default
+        let sessionConfiguration = self.sessionConfiguration.copy() as! URLSessionConfiguration
         // This really seems to be the critical timeout parameter for my usage. See also https://github.com/Alamofire/Alamofire/issues/1266 and https://stackoverflow.com/questions/19688175/nsurlsessionconfiguration-timeoutintervalforrequest-vs-nsurlsession-timeoutinter
         sessionConfiguration.timeoutIntervalForRequest = timeoutIntervalForRequest
 
@@ -148,7 +151,7 @@ class ServerNetworking : NSObject {
             sessionConfiguration.waitsForConnectivity = true
         }
         else if !Network.connected() {
-            completion?(nil, nil, .noNetworkError)
+            completion?(nil, nil, .noNetworkError, nil)
             return
         }
         
@@ -174,23 +177,23 @@ class ServerNetworking : NSObject {
         uploadTask.resume()
     }
 
-    private func processResponse(data:Data?, urlResponse:URLResponse?, error: Error?, completion:((_ serverResponse:[String:Any]?, _ statusCode:Int?, _ error:SyncServerError?)->())?) {
+    private func processResponse(data:Data?, urlResponse:URLResponse?, error: Error?, completion:((_ serverResponse:[String:Any]?, _ statusCode:Int?, _ error:SyncServerError?, _ urlResponse:HTTPURLResponse?)->())?) {
         if error == nil {
             // With an HTTP or HTTPS request, we get HTTPURLResponse back. See https://developer.apple.com/reference/foundation/urlsession/1407613-datatask
             guard let response = urlResponse as? HTTPURLResponse else {
-                completion?(nil, nil, .couldNotGetHTTPURLResponse)
+                completion?(nil, nil, .couldNotGetHTTPURLResponse, nil)
                 return
             }
             
             // Treating unauthorized specially because we attempt a credentials refresh in some cases when we get this.
             if response.statusCode == HTTPStatus.unauthorized.rawValue {
-                completion?(nil, response.statusCode, nil)
+                completion?(nil, response.statusCode, nil, response)
                 return
             }
             
             if response.statusCode == HTTPStatus.serviceUnavailable.rawValue {
                 ServerResponseCheck.session.failover {
-                    completion?(nil, response.statusCode, nil)
+                    completion?(nil, response.statusCode, nil, response)
                 }
                 
                 return
@@ -204,12 +207,12 @@ class ServerNetworking : NSObject {
                     try json = JSONSerialization.jsonObject(with: data!, options: JSONSerialization.ReadingOptions(rawValue: UInt(0)))
                 } catch (let error) {
                     Log.error("processResponse: Error in JSON conversion: \(error); statusCode= \(response.statusCode)")
-                    completion?(nil, response.statusCode, .jsonSerializationError(error))
+                    completion?(nil, response.statusCode, .jsonSerializationError(error), response)
                     return
                 }
                 
                 guard let jsonDict = json as? [String: Any] else {
-                    completion?(nil, response.statusCode, .errorConvertingServerResponse)
+                    completion?(nil, response.statusCode, .errorConvertingServerResponse, response)
                     return
                 }
                 
@@ -220,12 +223,12 @@ class ServerNetworking : NSObject {
                     resultDict[ServerConstants.httpResponseOAuth2AccessTokenKey] = accessTokenResponse
                 }
                 
-                completion?(resultDict, response.statusCode, nil)
+                completion?(resultDict, response.statusCode, nil, response)
             }
         }
         else {
             self.checkForNetworkAndReport()
-            completion?(nil, nil, .urlSessionError(error!))
+            completion?(nil, nil, .urlSessionError(error!), nil)
         }
     }
     
@@ -9,11 +9,12 @@ import Foundation
 import XCGLogger
 
 extension XCGLogger {
-    func msg(_ output: String) {
-        Log.info(output)
+    // The message is only built if some destination is logging at the info level. Passes along the call site, so it's not that of these methods.
+    func msg(_ output: @autoclosure () -> String, functionName: StaticString = #function, fileName: StaticString = #file, lineNumber: Int = #line) {
+        logln(.info, functionName: functionName, fileName: fileName, lineNumber: lineNumber) { output() }
     }
     
-    func special(_ output: String) {
-        Log.info(output)
+    func special(_ output: @autoclosure () -> String, functionName: StaticString = #function, fileName: StaticString = #file, lineNumber: Int = #line) {
+        logln(.info, functionName: functionName, fileName: fileName, lineNumber: lineNumber) { output() }
     }
 }
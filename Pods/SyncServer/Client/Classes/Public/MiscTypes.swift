@@ -73,6 +73,34 @@ extension SyncServer {
         }
     }
     
+    /// An immutable view of the sharing groups the user is a member of, as of the last save of a change to them. Published by the SyncServer after each index/sync, or other change; reading it doesn't touch Core Data. `version` increases with each publication.
+    public struct SharingGroupsSnapshot {
+        public let version: Int
+        
+        /// Keyed by sharingGroupUUID. `syncNeeded` in the sharing groups is non-nil.
+        public let sharingGroups: [String: SharingGroup]
+        
+        static let empty = SharingGroupsSnapshot(version: 0, sharingGroups: [])
+        
+        init(version: Int, sharingGroups: [SharingGroup]) {
+            self.version = version
+            var byUUID = [String: SharingGroup]()
+            for sharingGroup in sharingGroups {
+                byUUID[sharingGroup.sharingGroupUUID] = sharingGroup
+            }
+            self.sharingGroups = byUUID
+        }
+        
+        public subscript(sharingGroupUUID: String) -> SharingGroup? {
+            return sharingGroups[sharingGroupUUID]
+        }
+        
+        /// In no particular order.
+        public var all: [SharingGroup] {
+            return Array(sharingGroups.values)
+        }
+    }
+    
     public struct Invitation {
         public let code:String
         public let permission:Permission
@@ -7,6 +7,8 @@
 //
 
 import Foundation
+import CoreData
+import os
 import SMCoreLib
 import SyncServer_Shared
 import XCGLogger
@@ -34,6 +36,14 @@ public class SyncServer: NSObject {
     private var delayedSync = [DelayedSync]()
     private var stoppingSync = false
     
+    // Guards only the swap/read of `_sharingGroupsSnapshot`, so it's held for a reference copy, never across Core Data access. Heap allocated so the lock has a stable address.
+    private let sharingGroupsSnapshotLock: UnsafeMutablePointer<os_unfair_lock> = {
+        let lock = UnsafeMutablePointer<os_unfair_lock>.allocate(capacity: 1)
+        lock.initialize(to: os_unfair_lock())
+        return lock
+    }()
+    private var _sharingGroupsSnapshot = SharingGroupsSnapshot.empty
+    
 #if DEBUG
     // Only for testing.
     public static let backgroundTest = SMPersistItemBool(name:"SyncServer.backgroundTest", initialBoolValue:false,  persistType: .userDefaults)
@@ -105,6 +115,9 @@ public class SyncServer: NSObject {
         CoreData.registerSession(coreDataSession, forName: Constants.coreDataName)
         Migrations.session.run()
         
+        NotificationCenter.default.addObserver(self, selector: #selector(coreDataDidSave(_:)), name: .NSManagedObjectContextDidSave, object: coreDataSession.context)
+        publishSharingGroupsSnapshot()
+        
         Network.session().appStartup()
         ServerAPI.session.baseURL = serverURL.absoluteString
         
@@ -885,6 +898,40 @@ public class SyncServer: NSObject {
         return result
     }
     
+    /// The sharing groups, for frequent readers such as UI: O(1) lookup by sharingGroupUUID, with no Core Data access and no waiting on a sync. Updated after each save that changes the sharing groups, e.g., after an index/sync.
+    public var sharingGroupsSnapshot: SharingGroupsSnapshot {
+        os_unfair_lock_lock(sharingGroupsSnapshotLock)
+        let snapshot = _sharingGroupsSnapshot
+        os_unfair_lock_unlock(sharingGroupsSnapshotLock)
+        return snapshot
+    }
+    
+    @objc private func coreDataDidSave(_ notification: Notification) {
+        let changeKeys = [NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey]
+        let sharingEntriesChanged = changeKeys.contains { key in
+            guard let objects = notification.userInfo?[key] as? Set<NSManagedObject> else {
+                return false
+            }
+            return objects.contains { $0 is SharingEntry }
+        }
+        
+        if sharingEntriesChanged {
+            publishSharingGroupsSnapshot()
+        }
+    }
+    
+    // Saves happen within `CoreDataSync.perform`, which isn't reentrant, so this uses the context's `performAndWait` (which is) directly.
+    private func publishSharingGroupsSnapshot() {
+        var sharingGroups = [SharingGroup]()
+        CoreData.sessionNamed(Constants.coreDataName).performAndWait {
+            sharingGroups = SharingEntry.fetchAll().filter {!$0.removedFromGroup}.map {$0.toSharingGroup()}
+        }
+        
+        os_unfair_lock_lock(sharingGroupsSnapshotLock)
+        _sharingGroupsSnapshot = SharingGroupsSnapshot(version: _sharingGroupsSnapshot.version + 1, sharingGroups: sharingGroups)
+        os_unfair_lock_unlock(sharingGroupsSnapshotLock)
+    }
+    
     /**
         Operates in one of two modes:
      
@@ -18,9 +18,78 @@ struct LOT_Subpath {
   CGPoint endPoint;
   CGPoint controlPoint1;
   CGPoint controlPoint2;
+  // For curves, when lengths are cached: arc length from the start of the curve at t = (i + 1) / arcLengthCount. The last entry is the curve's length.
+  CGFloat *arcLengths;
+  NSInteger arcLengthCount;
   LOT_Subpath *nextSubpath;
 };
 
+// Roughly the largest error, in points, we accept in the length measured along a curve.
+static const CGFloat kLOTArcLengthTolerance = 0.05;
+static const NSInteger kLOTArcLengthMinSamples = 2;
+static const NSInteger kLOTArcLengthMaxSamples = 64;
+
+static void LOT_FreeSubpath(LOT_Subpath *subpath) {
+  free(subpath->arcLengths);
+  free(subpath);
+}
+
+// Samples the curve at evenly spaced t. How far the curve strays from its chord is bounded by how much longer the control polygon is than the chord, and the error of sampling it falls with the square of the number of samples; so flat curves get few samples and tightly bent ones more.
+static CGFloat *LOT_NewArcLengthTable(CGPoint fromPoint, CGPoint toPoint, CGPoint controlPoint1, CGPoint controlPoint2, NSInteger *count) {
+  CGFloat polygonLength = (LOT_PointDistanceFromPoint(fromPoint, controlPoint1) +
+                           LOT_PointDistanceFromPoint(controlPoint1, controlPoint2) +
+                           LOT_PointDistanceFromPoint(controlPoint2, toPoint));
+  CGFloat deviation = MAX(polygonLength - LOT_PointDistanceFromPoint(fromPoint, toPoint), 0);
+  NSInteger samples = (NSInteger)ceil(sqrt(deviation / kLOTArcLengthTolerance));
+  samples = MIN(MAX(samples, kLOTArcLengthMinSamples), kLOTArcLengthMaxSamples);
+  
+  CGFloat *arcLengths = (CGFloat *)malloc(sizeof(CGFloat) * samples);
+  CGFloat length = 0;
+  CGPoint previousPoint = fromPoint;
+  for (NSInteger i = 1; i <= samples; i ++) {
+    CGPoint point = LOT_PointInCubicCurve(fromPoint, controlPoint1, controlPoint2, toPoint, (CGFloat)i / samples);
+    length += LOT_PointDistanceFromPoint(previousPoint, point);
+    arcLengths[i - 1] = length;
+    previousPoint = point;
+  }
+  *count = samples;
+  return arcLengths;
+}
+
+static CGFloat *LOT_CopyArcLengthTable(const CGFloat *arcLengths, NSInteger count) {
+  if (!arcLengths || count == 0) {
+    return NULL;
+  }
+  CGFloat *copy = (CGFloat *)malloc(sizeof(CGFloat) * count);
+  memcpy(copy, arcLengths, sizeof(CGFloat) * count);
+  return copy;
+}
+
+// Maps a length along the path onto the subpath's t. Outside the subpath this is a linear extrapolation, as callers only care about its sign there. Inside a curve with an arc length table, it's a binary search of the table.
+static CGFloat LOT_SubpathTForLength(LOT_Subpath *subpath, CGFloat length, CGFloat beginningLength, CGFloat endLength) {
+  CGFloat t = LOT_RemapValue(length, beginningLength, endLength, 0, 1);
+  if (subpath->arcLengthCount == 0 || t <= 0 || t >= 1) {
+    return t;
+  }
+  
+  CGFloat target = length - beginningLength;
+  NSInteger low = 0;
+  NSInteger high = subpath->arcLengthCount - 1;
+  while (low < high) {
+    NSInteger mid = low + (high - low) / 2;
+    if (subpath->arcLengths[mid] < target) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  
+  CGFloat previousLength = low > 0 ? subpath->arcLengths[low - 1] : 0;
+  CGFloat sampleLength = subpath->arcLengths[low] - previousLength;
+  CGFloat fraction = sampleLength > 0 ? (target - previousLength) / sampleLength : 0;
+  return (low + fraction) / subpath->arcLengthCount;
+}
+
 @interface LOTBezierPath ()
 @property (nonatomic, readonly) LOT_Subpath *headSubpath;
 @end
@@ -97,7 +166,7 @@ struct LOT_Subpath {
   while (node) {
     LOT_Subpath *nextNode = node->nextSubpath;
     node->nextSubpath = NULL;
-    free(node);
+    LOT_FreeSubpath(node);
     node = nextNode;
   }
   headSubpath_ = NULL;
@@ -109,12 +178,25 @@ struct LOT_Subpath {
                   endPoint:(CGPoint)endPoint
              controlPoint1:(CGPoint)controlPoint1
              controlPoint1:(CGPoint)controlPoint2 {
+  [self addSubpathWithType:type length:length arcLengths:NULL arcLengthCount:0 endPoint:endPoint controlPoint1:controlPoint1 controlPoint1:controlPoint2];
+}
+
+// Takes ownership of arcLengths.
+- (void)addSubpathWithType:(CGPathElementType)type
+                    length:(CGFloat)length
+                arcLengths:(CGFloat *)arcLengths
+            arcLengthCount:(NSInteger)arcLengthCount
+                  endPoint:(CGPoint)endPoint
+             controlPoint1:(CGPoint)controlPoint1
+             controlPoint1:(CGPoint)controlPoint2 {
   LOT_Subpath *subPath = (LOT_Subpath *)malloc(sizeof(LOT_Subpath));
   subPath->type = type;
   subPath->length = length;
   subPath->endPoint = endPoint;
   subPath->controlPoint1 = controlPoint1;
   subPath->controlPoint2 = controlPoint2;
+  subPath->arcLengths = arcLengths;
+  subPath->arcLengthCount = arcLengthCount;
   subPath->nextSubpath = NULL;
   if (tailSubpath_ == NULL) {
     headSubpath_ = subPath;
@@ -161,12 +243,28 @@ struct LOT_Subpath {
 - (void)LOT_addCurveToPoint:(CGPoint)point
               controlPoint1:(CGPoint)cp1
               controlPoint2:(CGPoint)cp2 {
+  [self _addCurveToPoint:point controlPoint1:cp1 controlPoint2:cp2 copyingArcLengthsFrom:NULL];
+}
+
+// With a source subpath for the same curve, its arc length table is copied rather than measured again.
+- (void)_addCurveToPoint:(CGPoint)point
+           controlPoint1:(CGPoint)cp1
+           controlPoint2:(CGPoint)cp2
+   copyingArcLengthsFrom:(LOT_Subpath *)source {
   CGFloat length = 0;
+  CGFloat *arcLengths = NULL;
+  NSInteger arcLengthCount = 0;
   if (_cacheLengths) {
-    length = LOT_CubicLengthWithPrecision(self.currentPoint, point, cp1, cp2, 5);
+    if (source && source->arcLengthCount > 0) {
+      arcLengths = LOT_CopyArcLengthTable(source->arcLengths, source->arcLengthCount);
+      arcLengthCount = source->arcLengthCount;
+    } else {
+      arcLengths = LOT_NewArcLengthTable(self.currentPoint, point, cp1, cp2, &arcLengthCount);
+    }
+    length = arcLengths[arcLengthCount - 1];
     _length = _length + length;
   }
-  [self addSubpathWithType:kCGPathElementAddCurveToPoint length:length endPoint:point controlPoint1:cp1 controlPoint1:cp2];
+  [self addSubpathWithType:kCGPathElementAddCurveToPoint length:length arcLengths:arcLengths arcLengthCount:arcLengthCount endPoint:point controlPoint1:cp1 controlPoint1:cp2];
   CGPathAddCurveToPoint(_path, NULL, cp1.x, cp1.y, cp2.x, cp2.y, point.x, point.y);
 }
 
@@ -217,15 +315,20 @@ struct LOT_Subpath {
   LOT_Subpath *nextSubpath = bezierPath.headSubpath;
   while (nextSubpath) {
     CGFloat length = 0;
+    CGFloat *arcLengths = NULL;
+    NSInteger arcLengthCount = 0;
     if (self.cacheLengths) {
       if (bezierPath.cacheLengths) {
         length = nextSubpath->length;
+        arcLengths = LOT_CopyArcLengthTable(nextSubpath->arcLengths, nextSubpath->arcLengthCount);
+        arcLengthCount = arcLengths ? nextSubpath->arcLengthCount : 0;
       } else {
         // No previous length data, measure.
         if (nextSubpath->type == kCGPathElementAddLineToPoint) {
           length = LOT_PointDistanceFromPoint(self.currentPoint, nextSubpath->endPoint);
         } else if (nextSubpath->type == kCGPathElementAddCurveToPoint) {
-          length = LOT_CubicLengthWithPrecision(self.currentPoint, nextSubpath->endPoint, nextSubpath->controlPoint1, nextSubpath->controlPoint2, 5);
+          arcLengths = LOT_NewArcLengthTable(self.currentPoint, nextSubpath->endPoint, nextSubpath->controlPoint1, nextSubpath->controlPoint2, &arcLengthCount);
+          length = arcLengths[arcLengthCount - 1];
         } else if (nextSubpath->type == kCGPathElementCloseSubpath) {
           length = LOT_PointDistanceFromPoint(self.currentPoint, nextSubpath->endPoint);
         }
@@ -234,6 +337,8 @@ struct LOT_Subpath {
     _length = _length + length;
     [self addSubpathWithType:nextSubpath->type
                       length:length
+                  arcLengths:arcLengths
+              arcLengthCount:arcLengthCount
                     endPoint:nextSubpath->endPoint
                controlPoint1:nextSubpath->controlPoint1
                controlPoint1:nextSubpath->controlPoint2];
@@ -324,8 +429,8 @@ struct LOT_Subpath {
       // ---------------ooooooooooooooooooooooooooooooooooooooooooooooooo-------------------
       // Start          |currentStartLength             currentEndLength|                End
       
-      CGFloat currentSpanStartT = LOT_RemapValue(currentStartLength, subpathBeginningLength, subpathEndLength, 0, 1);
-      CGFloat currentSpanEndT = LOT_RemapValue(currentEndLength, subpathBeginningLength, subpathEndLength, 0, 1);
+      CGFloat currentSpanStartT = LOT_SubpathTForLength(subpath, currentStartLength, subpathBeginningLength, subpathEndLength);
+      CGFloat currentSpanEndT = LOT_SubpathTForLength(subpath, currentEndLength, subpathBeginningLength, subpathEndLength);
       
       // At this point currentSpan start and end T can be less than 0 or greater than 1
       
@@ -354,6 +459,8 @@ struct LOT_Subpath {
         cp1 = subpath->controlPoint1;
         cp2 = subpath->controlPoint2;
         end = subpath->endPoint;
+        // Whether this is the whole curve, so its arc lengths can be reused.
+        BOOL wholeCurve = YES;
         
         if (currentSpanStartT >= 0) {
           // The current drawable span either starts with this subpath or along this subpath.
@@ -369,7 +476,9 @@ struct LOT_Subpath {
             currentPoint = F;
             cp1 = E;
             cp2 = C;
+            // Splitting keeps t linear, so the end T carries over onto the remaining curve exactly.
             currentSpanEndT = LOT_RemapValue(currentSpanEndT, currentSpanStartT, 1, 0, 1);
+            wholeCurve = NO;
           }
           [self LOT_moveToPoint:currentPoint];
         }
@@ -384,8 +493,9 @@ struct LOT_Subpath {
           cp1 = A;
           cp2 = D;
           end = F;
+          wholeCurve = NO;
         }
-        [self LOT_addCurveToPoint:end controlPoint1:cp1 controlPoint2:cp2];
+        [self _addCurveToPoint:end controlPoint1:cp1 controlPoint2:cp2 copyingArcLengthsFrom:wholeCurve ? subpath : NULL];
       }
 
       if (currentSpanEndT <= 1) {
@@ -395,7 +505,7 @@ struct LOT_Subpath {
             while (subpath) {
                 LOT_Subpath *nextNode = subpath->nextSubpath;
                 subpath->nextSubpath = NULL;
-                free(subpath);
+                LOT_FreeSubpath(subpath);
                 subpath = nextNode;
             }
             break;
@@ -417,7 +527,7 @@ struct LOT_Subpath {
     
     LOT_Subpath *nextNode = subpath->nextSubpath;
     subpath->nextSubpath = NULL;
-    free(subpath);
+    LOT_FreeSubpath(subpath);
     subpath = nextNode;
   }
 }
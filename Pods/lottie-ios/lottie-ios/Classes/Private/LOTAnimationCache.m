@@ -8,11 +8,30 @@
 
 #import "LOTAnimationCache.h"
 
-const NSInteger kLOTCacheSize = 50;
+// Compositions vary hugely in size, so the cache is bounded by cost (by default, the size of the JSON an animation was loaded from) rather than by count.
+const NSUInteger kLOTCacheDefaultTotalCostLimit = 20 * 1024 * 1024;
+
+// Used when the caller doesn't give a cost.
+const NSUInteger kLOTCacheDefaultAnimationCost = 100 * 1024;
+
+// A node in the LRU list. The dictionary owns the nodes; the list links them from most to least recently used, so a hit, insertion or eviction is O(1).
+@interface LOTAnimationCacheEntry : NSObject {
+  @package
+  NSString *_key;
+  LOTComposition *_animation;
+  NSUInteger _cost;
+  __unsafe_unretained LOTAnimationCacheEntry *_prev;
+  __unsafe_unretained LOTAnimationCacheEntry *_next;
+}
+@end
+
+@implementation LOTAnimationCacheEntry
+@end
 
 @implementation LOTAnimationCache {
-  NSMutableDictionary *animationsCache_;
-  NSMutableArray *lruOrderArray_;
+  NSMutableDictionary<NSString *, LOTAnimationCacheEntry *> *entries_;
+  LOTAnimationCacheEntry *head_;
+  LOTAnimationCacheEntry *tail_;
 }
 
 + (instancetype)sharedCache {
@@ -27,47 +46,131 @@ const NSInteger kLOTCacheSize = 50;
 - (instancetype)init {
   self = [super init];
   if (self) {
-    animationsCache_ = [[NSMutableDictionary alloc] init];
-    lruOrderArray_ = [[NSMutableArray alloc] init];
+    entries_ = [[NSMutableDictionary alloc] init];
+    _totalCostLimit = kLOTCacheDefaultTotalCostLimit;
   }
   return self;
 }
 
+#pragma mark - LRU List
+
+- (void)_unlinkEntry:(LOTAnimationCacheEntry *)entry {
+  if (entry->_prev) {
+    entry->_prev->_next = entry->_next;
+  } else {
+    head_ = entry->_next;
+  }
+  if (entry->_next) {
+    entry->_next->_prev = entry->_prev;
+  } else {
+    tail_ = entry->_prev;
+  }
+  entry->_prev = nil;
+  entry->_next = nil;
+}
+
+- (void)_insertEntryAtHead:(LOTAnimationCacheEntry *)entry {
+  entry->_prev = nil;
+  entry->_next = head_;
+  if (head_) {
+    head_->_prev = entry;
+  }
+  head_ = entry;
+  if (!tail_) {
+    tail_ = entry;
+  }
+}
+
+- (void)_removeEntry:(LOTAnimationCacheEntry *)entry {
+  // The dictionary may hold the last reference to the entry.
+  NSString *key = entry->_key;
+  _totalCost -= entry->_cost;
+  [self _unlinkEntry:entry];
+  [entries_ removeObjectForKey:key];
+}
+
+- (void)_trimToCostLimit {
+  while (_totalCost > _totalCostLimit && tail_) {
+    [self _removeEntry:tail_];
+  }
+}
+
+#pragma mark - Public
+
+- (void)setTotalCostLimit:(NSUInteger)totalCostLimit {
+  _totalCostLimit = totalCostLimit;
+  [self _trimToCostLimit];
+}
+
+- (NSUInteger)count {
+  return entries_.count;
+}
+
 - (void)addAnimation:(LOTComposition *)animation forKey:(NSString *)key {
-  if (lruOrderArray_.count >= kLOTCacheSize) {
-    NSString *oldKey = lruOrderArray_[0];
-    [animationsCache_ removeObjectForKey:oldKey];
-    [lruOrderArray_ removeObject:oldKey];
+  [self addAnimation:animation forKey:key cost:kLOTCacheDefaultAnimationCost];
+}
+
+- (void)addAnimation:(LOTComposition *)animation forKey:(NSString *)key cost:(NSUInteger)cost {
+  if (!entries_ || !animation || !key) {
+    return;
   }
-  [lruOrderArray_ removeObject:key];
-  [lruOrderArray_ addObject:key];
-  [animationsCache_ setObject:animation forKey:key];
+  
+  LOTAnimationCacheEntry *entry = entries_[key];
+  if (entry) {
+    [self _removeEntry:entry];
+  }
+  
+  // Caching this would only push everything else out.
+  if (cost > _totalCostLimit) {
+    return;
+  }
+  
+  entry = [[LOTAnimationCacheEntry alloc] init];
+  entry->_key = [key copy];
+  entry->_animation = animation;
+  entry->_cost = cost;
+  entries_[entry->_key] = entry;
+  [self _insertEntryAtHead:entry];
+  _totalCost += cost;
+  
+  [self _trimToCostLimit];
 }
 
 - (LOTComposition *)animationForKey:(NSString *)key {
   if (!key) {
     return nil;
   }
-  LOTComposition *animation = [animationsCache_ objectForKey:key];
-  [lruOrderArray_ removeObject:key];
-  [lruOrderArray_ addObject:key];
-  return animation;
+  LOTAnimationCacheEntry *entry = entries_[key];
+  if (!entry) {
+    return nil;
+  }
+  if (entry != head_) {
+    [self _unlinkEntry:entry];
+    [self _insertEntryAtHead:entry];
+  }
+  return entry->_animation;
 }
 
 - (void)clearCache {
-  [animationsCache_ removeAllObjects];
-  [lruOrderArray_ removeAllObjects];
+  [entries_ removeAllObjects];
+  head_ = nil;
+  tail_ = nil;
+  _totalCost = 0;
 }
 
 - (void)removeAnimationForKey:(NSString *)key {
-  [lruOrderArray_ removeObject:key];
-  [animationsCache_ removeObjectForKey:key];
+  if (!key) {
+    return;
+  }
+  LOTAnimationCacheEntry *entry = entries_[key];
+  if (entry) {
+    [self _removeEntry:entry];
+  }
 }
 
 - (void)disableCaching {
   [self clearCache];
-  animationsCache_ = nil;
-  lruOrderArray_ = nil;
+  entries_ = nil;
 }
 
 @end
@@ -79,7 +79,7 @@ static NSString * const kCompContainerAnimationKey = @"play";
         
         LOTComposition *laScene = [[LOTComposition alloc] initWithJSON:animationJSON withAssetBundle:[NSBundle mainBundle]];
         dispatch_async(dispatch_get_main_queue(), ^(void) {
-          [[LOTAnimationCache sharedCache] addAnimation:laScene forKey:url.absoluteString];
+          [[LOTAnimationCache sharedCache] addAnimation:laScene forKey:url.absoluteString cost:animationData.length];
           laScene.cacheKey = url.absoluteString;
           [self _initializeAnimationContainer];
           [self _setupWithSceneModel:laScene];
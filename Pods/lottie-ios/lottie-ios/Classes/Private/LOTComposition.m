@@ -46,7 +46,7 @@
                                                                          options:0 error:&error] : nil;
   if (JSONObject && !error) {
     LOTComposition *laScene = [[self alloc] initWithJSON:JSONObject withAssetBundle:bundle];
-    [[LOTAnimationCache sharedCache] addAnimation:laScene forKey:animationName];
+    [[LOTAnimationCache sharedCache] addAnimation:laScene forKey:animationName cost:jsonData.length];
     laScene.cacheKey = animationName;
     return laScene;
   }
@@ -69,7 +69,7 @@
   if (JSONObject && !error) {
     LOTComposition *laScene = [[self alloc] initWithJSON:JSONObject withAssetBundle:[NSBundle mainBundle]];
     laScene.rootDirectory = [filePath stringByDeletingLastPathComponent];
-    [[LOTAnimationCache sharedCache] addAnimation:laScene forKey:animationName];
+    [[LOTAnimationCache sharedCache] addAnimation:laScene forKey:animationName cost:jsonData.length];
     laScene.cacheKey = animationName;
     return laScene;
   }
@@ -17,9 +17,21 @@ NS_ASSUME_NONNULL_BEGIN
 /// Global Cache
 + (instancetype)sharedCache;
 
-/// Adds animation to the cache
+/// Upper bound on the total cost of the cached animations. Least recently used animations are evicted to stay under it.
+@property (nonatomic, assign) NSUInteger totalCostLimit;
+
+/// Total cost of the cached animations
+@property (nonatomic, readonly) NSUInteger totalCost;
+
+/// Number of cached animations
+@property (nonatomic, readonly) NSUInteger count;
+
+/// Adds animation to the cache, with a default cost
 - (void)addAnimation:(LOTComposition *)animation forKey:(NSString *)key;
 
+/// Adds animation to the cache. The cost is typically the size in bytes of the JSON it was loaded from.
+- (void)addAnimation:(LOTComposition *)animation forKey:(NSString *)key cost:(NSUInteger)cost;
+
 /// Returns animation from cache.
 - (LOTComposition * _Nullable)animationForKey:(NSString *)key;
 
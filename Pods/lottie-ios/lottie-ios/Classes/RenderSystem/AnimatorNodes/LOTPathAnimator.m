@@ -12,6 +12,7 @@
 @implementation LOTPathAnimator {
   LOTShapePath *_pathConent;
   LOTPathInterpolator *_interpolator;
+  LOTBezierPath *_untrimmedPath;
 }
 
 - (instancetype _Nonnull)initWithInputNode:(LOTAnimatorNode *_Nullable)inputNode
@@ -33,7 +34,15 @@
 }
 
 - (void)performLocalUpdate {
-  self.localPath = [_interpolator pathForFrame:self.currentFrame cacheLengths:self.pathShouldCacheLengths];
+  if (!self.pathShouldCacheLengths) {
+    self.localPath = [_interpolator pathForFrame:self.currentFrame cacheLengths:NO];
+    return;
+  }
+  // Lengths are cached for trimming. A trim changes the local path in place, so it's rebuilt every time the trim changes, even when the shape hasn't. In that case start again from a copy of the untrimmed path, which keeps its arc lengths rather than measuring every curve again.
+  if (!_untrimmedPath || [_interpolator hasUpdateForFrame:self.currentFrame]) {
+    _untrimmedPath = [_interpolator pathForFrame:self.currentFrame cacheLengths:YES];
+  }
+  self.localPath = [_untrimmedPath copy];
 }
 
 @end
@@ -15,42 +15,62 @@
 
 @end
 
-@implementation LOTValueInterpolator
+@implementation LOTValueInterpolator {
+  // Keyframe times, unboxed once, in keyframe order.
+  CGFloat *_keyframeTimes;
+  NSInteger _keyframeCount;
+  // Indexes of the leading and trailing keyframes of the current span, or NSNotFound.
+  NSInteger _leadingIndex;
+  NSInteger _trailingIndex;
+  BOOL _spanInitialized;
+}
 
 - (instancetype)initWithKeyframes:(NSArray <LOTKeyframe *> *)keyframes {
   self = [super init];
   if (self) {
     _keyframes = keyframes;
+    _keyframeCount = keyframes.count;
+    _keyframeTimes = (CGFloat *)malloc(sizeof(CGFloat) * MAX(_keyframeCount, 1));
+    for (NSInteger i = 0; i < _keyframeCount; i ++) {
+      _keyframeTimes[i] = keyframes[i].keyframeTime.floatValue;
+    }
+    _leadingIndex = NSNotFound;
+    _trailingIndex = NSNotFound;
   }
   return self;
 }
 
+- (void)dealloc {
+  free(_keyframeTimes);
+}
+
 - (BOOL)hasUpdateForFrame:(NSNumber *)frame {
   if (self.hasDelegateOverride) {
     return YES;
   }
+  CGFloat frameValue = frame.floatValue;
   /*
    Cases we dont update keyframe
    if time is in span and leading keyframe is hold
    if trailing keyframe is nil and time is after leading
    if leading keyframe is nil and time is before trailing
    */
-  if (self.leadingKeyframe &&
-      self.trailingKeyframe == nil &&
-      self.leadingKeyframe.keyframeTime.floatValue < frame.floatValue) {
+  if (_leadingIndex != NSNotFound &&
+      _trailingIndex == NSNotFound &&
+      _keyframeTimes[_leadingIndex] < frameValue) {
     // Frame is after bounds of keyframes. Clip
     return NO;
   }
-  if (self.trailingKeyframe &&
-      self.leadingKeyframe == nil &&
-      self.trailingKeyframe.keyframeTime.floatValue > frame.floatValue) {
+  if (_trailingIndex != NSNotFound &&
+      _leadingIndex == NSNotFound &&
+      _keyframeTimes[_trailingIndex] > frameValue) {
     // Frame is before keyframes bounds. Clip.
     return NO;
   }
-  if (self.leadingKeyframe && self.trailingKeyframe &&
+  if (_leadingIndex != NSNotFound && _trailingIndex != NSNotFound &&
       self.leadingKeyframe.isHold &&
-      self.leadingKeyframe.keyframeTime.floatValue < frame.floatValue &&
-      self.trailingKeyframe.keyframeTime.floatValue > frame.floatValue) {
+      _keyframeTimes[_leadingIndex] < frameValue &&
+      _keyframeTimes[_trailingIndex] > frameValue) {
     // Frame is in span and current span is a hold keyframe
     return NO;
   }
@@ -58,103 +78,84 @@
   return YES;
 }
 
-- (void)updateKeyframeSpanForFrame:(NSNumber *)frame {
-  if (self.leadingKeyframe == nil &&
-      self.trailingKeyframe == nil) {
-    // Set Initial Keyframes
-    LOTKeyframe *first = _keyframes.firstObject;
-    if (first.keyframeTime.floatValue > 0) {
-      self.trailingKeyframe = first;
+// The span for a frame is the last keyframe at or before it, and the keyframe after that. Returns the index of the trailing keyframe, i.e., the first keyframe after the frame; _keyframeCount if there isn't one.
+- (NSInteger)_trailingIndexForFrame:(CGFloat)frameValue {
+  NSInteger low = 0;
+  NSInteger high = _keyframeCount;
+  while (low < high) {
+    NSInteger mid = low + (high - low) / 2;
+    if (_keyframeTimes[mid] <= frameValue) {
+      low = mid + 1;
     } else {
-      self.leadingKeyframe = first;
-      if (_keyframes.count > 1) {
-        self.trailingKeyframe = _keyframes[1];
-      }
+      high = mid;
     }
   }
-  if (self.trailingKeyframe && frame.floatValue >= self.trailingKeyframe.keyframeTime.floatValue) {
-    // Frame is after current span, can move forward
-    NSInteger index = [_keyframes indexOfObject:self.trailingKeyframe];
-    BOOL keyframeFound = NO;
-    
-    LOTKeyframe *testLeading = self.trailingKeyframe;
-    LOTKeyframe *testTrailing = nil;
-    
-    while (keyframeFound == NO) {
-      index ++;
-      if (index < _keyframes.count) {
-        testTrailing = _keyframes[index];
-        if (frame.floatValue < testTrailing.keyframeTime.floatValue) {
-          // This is the span.
-          keyframeFound = YES;
-        } else {
-          testLeading = testTrailing;
-        }
-      } else {
-        // Leading is Last object
-        testTrailing = nil;
-        keyframeFound = YES;
-      }
-    }
-    self.leadingKeyframe = testLeading;
-    self.trailingKeyframe = testTrailing;
-  } else if (self.leadingKeyframe && frame.floatValue < self.leadingKeyframe.keyframeTime.floatValue) {
-    // Frame is before current span, can move back a span
-    NSInteger index = [_keyframes indexOfObject:self.leadingKeyframe];
-    BOOL keyframeFound = NO;
-    
-    LOTKeyframe *testLeading = nil;
-    LOTKeyframe *testTrailing = self.leadingKeyframe;
-    
-    while (keyframeFound == NO) {
-      index --;
-      if (index >= 0) {
-        testLeading = _keyframes[index];
-        if (frame.floatValue >= testLeading.keyframeTime.floatValue) {
-          // This is the span.
-          keyframeFound = YES;
-        } else {
-          testTrailing = testLeading;
-        }
-      } else {
-        // Trailing is first object
-        testLeading = nil;
-        keyframeFound = YES;
-      }
-    }
-    self.leadingKeyframe = testLeading;
-    self.trailingKeyframe = testTrailing;
+  return low;
+}
+
+- (BOOL)_span:(NSInteger)trailingIndex containsFrame:(CGFloat)frameValue {
+  return (trailingIndex == 0 || _keyframeTimes[trailingIndex - 1] <= frameValue) &&
+    (trailingIndex == _keyframeCount || frameValue < _keyframeTimes[trailingIndex]);
+}
+
+- (void)updateKeyframeSpanForFrame:(NSNumber *)frame {
+  if (_keyframeCount == 0) {
+    return;
+  }
+  CGFloat frameValue = frame.floatValue;
+  NSInteger currentTrailing = _trailingIndex == NSNotFound ? _keyframeCount : _trailingIndex;
+  
+  NSInteger trailing;
+  if (_spanInitialized && [self _span:currentTrailing containsFrame:frameValue]) {
+    // Still in the current span.
+    return;
+  } else if (_spanInitialized && currentTrailing < _keyframeCount &&
+             [self _span:currentTrailing + 1 containsFrame:frameValue]) {
+    // Sequential playback: moved into the next span.
+    trailing = currentTrailing + 1;
+  } else {
+    // Seek
+    trailing = [self _trailingIndexForFrame:frameValue];
   }
+  
+  _spanInitialized = YES;
+  _leadingIndex = trailing > 0 ? trailing - 1 : NSNotFound;
+  _trailingIndex = trailing < _keyframeCount ? trailing : NSNotFound;
+  self.leadingKeyframe = _leadingIndex != NSNotFound ? _keyframes[_leadingIndex] : nil;
+  self.trailingKeyframe = _trailingIndex != NSNotFound ? _keyframes[_trailingIndex] : nil;
 }
 
 - (CGFloat)progressForFrame:(NSNumber *)frame {
   [self updateKeyframeSpanForFrame:frame];
+  CGFloat frameValue = frame.floatValue;
   // At this point frame definitely exists between leading and trailing keyframes
-  if (self.leadingKeyframe.keyframeTime == frame) {
+  if (_leadingIndex != NSNotFound && _keyframeTimes[_leadingIndex] == frameValue) {
     // Frame is leading keyframe
     return 0;
   }
-  if (self.trailingKeyframe == nil) {
+  if (_trailingIndex == NSNotFound) {
     // Frame is after end of keyframe timeline
     return 0;
   }
-  if (self.leadingKeyframe.isHold) {
-    // Hold Keyframe
-    return 0;
-  }
-  if (self.leadingKeyframe == nil) {
+  if (_leadingIndex == NSNotFound) {
     // Frame is before start of keyframe timeline
     return 1;
   }
+  LOTKeyframe *leadingKeyframe = self.leadingKeyframe;
+  LOTKeyframe *trailingKeyframe = self.trailingKeyframe;
+  if (leadingKeyframe.isHold) {
+    // Hold Keyframe
+    return 0;
+  }
 
-  CGFloat progression = LOT_RemapValue(frame.floatValue, self.leadingKeyframe.keyframeTime.floatValue, self.trailingKeyframe.keyframeTime.floatValue, 0, 1);
+  CGFloat progression = LOT_RemapValue(frameValue, _keyframeTimes[_leadingIndex], _keyframeTimes[_trailingIndex], 0, 1);
   
-  if ((self.leadingKeyframe.outTangent.x != self.leadingKeyframe.outTangent.y ||
-      self.trailingKeyframe.inTangent.x != self.trailingKeyframe.inTangent.y) &&
-      (!LOT_CGPointIsZero(self.leadingKeyframe.outTangent) &&
-       !LOT_CGPointIsZero(self.trailingKeyframe.inTangent))) {
+  if ((leadingKeyframe.outTangent.x != leadingKeyframe.outTangent.y ||
+      trailingKeyframe.inTangent.x != trailingKeyframe.inTangent.y) &&
+      (!LOT_CGPointIsZero(leadingKeyframe.outTangent) &&
+       !LOT_CGPointIsZero(trailingKeyframe.inTangent))) {
     // Bezier Time Curve
-    progression = LOT_CubicBezierInterpolate(CGPointMake(0, 0), self.leadingKeyframe.outTangent, self.trailingKeyframe.inTangent, CGPointMake(1, 1), progression);
+    progression = LOT_CubicBezierInterpolate(CGPointMake(0, 0), leadingKeyframe.outTangent, trailingKeyframe.inTangent, CGPointMake(1, 1), progression);
   }
   
   return progression;
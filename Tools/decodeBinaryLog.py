@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+
+# Decodes the ring file written by BinaryLogDestination (see Code/App Launch/BinaryLogDestination.swift) into text, oldest record first.
+# usage: ./decodeBinaryLog.py Logfile.bin [Logfile.bin.sites]
+
+import os
+import struct
+import sys
+from datetime import datetime
+
+MAGIC = b"XCGB"
+HEADER_SIZE = 32
+RECORD_MARKER = 0xB10C
+RECORD_HEADER_SIZE = 28
+TYPE_MESSAGE = 1
+TYPE_PAD = 2
+LEVELS = ["Verbose", "Debug", "Info", "Warning", "Error", "Severe", "None"]
+
+def loadCallSites(path):
+    callSites = {}
+    if not os.path.exists(path):
+        return callSites
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            fields = line.rstrip("\n").split("\t")
+            if len(fields) == 4:
+                callSites[int(fields[0])] = (os.path.basename(fields[1]), fields[2], fields[3])
+    return callSites
+
+# Yields (offset, record) for the records starting at `start` up to `end`. Returns at a pad record, or anything that isn't a valid record.
+def records(data, start, end):
+    offset = start
+    while offset + 3 <= end:
+        marker, recordType = struct.unpack_from("<HB", data, offset)
+        if marker != RECORD_MARKER or recordType != TYPE_MESSAGE or offset + RECORD_HEADER_SIZE > end:
+            return
+        _, _, level, callSite, timestamp, threadID, length = struct.unpack_from("<HBBIdQI", data, offset)
+        if offset + RECORD_HEADER_SIZE + length > end:
+            return
+        message = data[offset + RECORD_HEADER_SIZE:offset + RECORD_HEADER_SIZE + length].decode("utf-8", "replace")
+        yield (level, callSite, timestamp, threadID, message)
+        offset += RECORD_HEADER_SIZE + length
+
+# After the ring has wrapped, the write offset can be in the middle of an old record. Find the next record start.
+def resync(data, start, end):
+    marker = struct.pack("<H", RECORD_MARKER)
+    offset = data.find(marker, start, end)
+    while offset != -1:
+        if offset + RECORD_HEADER_SIZE <= end:
+            _, recordType, level, _, _, _, length = struct.unpack_from("<HBBIdQI", data, offset)
+            if recordType == TYPE_MESSAGE and level < len(LEVELS) and offset + RECORD_HEADER_SIZE + length <= end:
+                return offset
+        offset = data.find(marker, offset + 1, end)
+    return end
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("usage: %s <ring file> [<call sites file>]" % sys.argv[0])
+
+    ringPath = sys.argv[1]
+    sitesPath = sys.argv[2] if len(sys.argv) > 2 else ringPath + ".sites"
+
+    with open(ringPath, "rb") as f:
+        contents = f.read()
+
+    if contents[:4] != MAGIC:
+        sys.exit("Not a binary log file: %s" % ringPath)
+
+    _, capacity, writeOffset, wraps = struct.unpack_from("<IQQQ", contents, 4)
+    data = contents[HEADER_SIZE:HEADER_SIZE + capacity]
+    callSites = loadCallSites(sitesPath)
+
+    segments = []
+    if wraps > 0:
+        segments.append((resync(data, writeOffset, capacity), capacity))
+    segments.append((0, writeOffset))
+
+    for (start, end) in segments:
+        for (level, callSite, timestamp, threadID, message) in records(data, start, end):
+            (fileName, line, function) = callSites.get(callSite, ("?", "?", "?"))
+            date = datetime.fromtimestamp(timestamp).strftime("%Y-%m-%d %H:%M:%S.%f")[:-3]
+            levelName = LEVELS[level] if level < len(LEVELS) else str(level)
+            print("%s [%s] [%x] [%s:%s] %s > %s" % (date, levelName, threadID, fileName, line, function, message))
+
+if __name__ == "__main__":
+    main()